@@ -99,6 +99,24 @@ extern void ccdbgDevice_setPinDirection(CCDBG_PIN pin, int output);
 extern void ccdbgDevice_delay(void);
 #endif
 
+/**
+ * sleep, letting other processes run; used in waiting for the chip
+ *
+ * microseconds - duration
+ */
+#ifndef ccdbgDevice_sleep
+extern void ccdbgDevice_sleep(unsigned int microseconds);
+#endif
+
+/**
+ * get the time from a monotonic clock
+ *
+ * returns microseconds since an arbitrary starting point
+ */
+#ifndef ccdbgDevice_getMicroseconds
+extern unsigned long long ccdbgDevice_getMicroseconds(void);
+#endif
+
 /**
  * reset
  */
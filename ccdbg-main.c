@@ -29,10 +29,55 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "intelhex.h"
+#include "sdcc.h"
+#include "gdbserver.h"
 
 #define KB(x)	((float)x / 1024.0)
 
+#define PROFILE_HISTOGRAM_SIZE		0x10000
+#define PROFILE_MAXIMUM_ENTRIES		30
+
+#define TRACE_SIGNATURE				"CCTR"
+#define TRACE_MAXIMUM_INSTRUCTIONS	0x1000000
+
+#define TIMING_MAXIMUM_FUNCTIONS	(CCDBG_NUMBER_OF_BREAKPOINTS / 2)
+#define TIMING_TIMEOUT				10000000	// microseconds without a breakpoint hit
+#define SLEEP_TIMER_FREQUENCY		32768
+
+#define LOG_MAXIMUM_DRAIN_SIZE		0x10000
+
+#define WATCH_MAXIMUM_VARIABLES		32
+#define WATCH_MAXIMUM_SIZE			32
+
+#define STACK_PAINT_PATTERN			0xa5
+#define STACK_PROBE_SIZE			4
+#define STACK_LINEAR_SCAN_SIZE		32
+#define IDATA_WINDOW_START			0x1f00		// IDATA 0x00 ~ 0xff in XDATA
+
+#define FLASH_PIPELINE_PAGES		4
+
+#define RUN_TIMEOUT					10000000	// microseconds to reach a stop address
+
+#define SNAPSHOT_SIGNATURE			"CCSS"
+#define SNAPSHOT_HEADER_SIZE		10
+
+enum {
+	REG_SP			= 0x7081,
+	REG_ST0			= 0x7095,
+	REG_CLKCONSTA	= 0x709e,
+	REG_T1STAT		= 0x70af,
+	REG_T1CNTL		= 0x70e2,
+	REG_T1CTL		= 0x70e4
+};
+
+enum {
+	TIMER_1,
+	TIMER_SLEEP
+};
+
 enum {
 	UNKNOWN_COMMAND = -1,
 	COMMAND_EXECUTE_DEBUG_COMMAND,
@@ -50,6 +95,18 @@ enum {
 	COMMAND_WRITE_FLASH,
 	COMMAND_ERASE_FLASH,
 	COMMAND_LOCK_DEBUG_INTERFACE,
+	COMMAND_RUN_FROM_SRAM,
+	COMMAND_PROFILE,
+	COMMAND_TRACE,
+	COMMAND_TIME_FUNCTIONS,
+	COMMAND_DRAIN_LOG,
+	COMMAND_SAMPLE_VARIABLES,
+	COMMAND_STACK_USAGE,
+	COMMAND_TAKE_SNAPSHOT,
+	COMMAND_RESTORE_SNAPSHOT,
+	COMMAND_GDB_SERVER,
+	COMMAND_WAIT_FOR_HALT,
+	COMMAND_DIGEST,
 	COMMAND_ITEMS
 };
 
@@ -68,6 +125,18 @@ enum {
 #define WRITE_FLASH				"-wf"
 #define ERASE_FLASH				"-ef"
 #define LOCK_DEBUG_INTERFACE	"-ld"
+#define RUN_FROM_SRAM			"-rr"
+#define PROFILE					"-pf"
+#define TRACE					"-tr"
+#define TIME_FUNCTIONS			"-ft"
+#define DRAIN_LOG				"-lg"
+#define SAMPLE_VARIABLES		"-vs"
+#define STACK_USAGE				"-sk"
+#define TAKE_SNAPSHOT			"-ss"
+#define RESTORE_SNAPSHOT		"-rs"
+#define GDB_SERVER				"-gd"
+#define WAIT_FOR_HALT			"-wh"
+#define DIGEST					"-dg"
 
 static const char *commandList[] = {
 		EXECUTE_DEBUG_COMMAND,
@@ -84,7 +153,19 @@ static const char *commandList[] = {
 		READ_FLASH,
 		WRITE_FLASH,
 		ERASE_FLASH,
-		LOCK_DEBUG_INTERFACE
+		LOCK_DEBUG_INTERFACE,
+		RUN_FROM_SRAM,
+		PROFILE,
+		TRACE,
+		TIME_FUNCTIONS,
+		DRAIN_LOG,
+		SAMPLE_VARIABLES,
+		STACK_USAGE,
+		TAKE_SNAPSHOT,
+		RESTORE_SNAPSHOT,
+		GDB_SERVER,
+		WAIT_FOR_HALT,
+		DIGEST
 };
 
 enum {
@@ -141,63 +222,145 @@ static struct {
 };
 
 static const char *commandHelpList[] = {
-				"  "EXECUTE_DEBUG_COMMAND" <command> [input bytes] \n"
+				"  " EXECUTE_DEBUG_COMMAND " <command> [input bytes] \n"
 						"    commands:\n"
-						"      "DEBUG_ERASE_FLASH", erase flash\n"
-						"      "DEBUG_WRITE_CONFIGURATION", write debug configuration data\n"
-						"      "DEBUG_READ_CONFIGURATION", read debug configuration data\n"
-						"      "DEBUG_GET_PC", get value of program counter\n"
-						"      "DEBUG_READ_STATUS", read debug status\n"
-						"      "DEBUG_SET_BREAKPOINT", set breakpoint\n"
-						"      "DEBUG_HALT_CPU", halt CPU operation\n"
-						"      "DEBUG_RESUME_CPU", resume CPU operation\n"
-						"      "DEBUG_RUN_INSTRUCTION", run debug instruction\n"
-						"      "DEBUG_STEP_CPU", step CPU instruction\n"
-						"      "DEBUG_GET_BM", get memory bank\n"
-						"      "DEBUG_GET_ID", get chip ID\n"
-						"      "DEBUG_BURST_WRITE", perform burst write operation\n"
-						"    e.g. "EXECUTE_DEBUG_COMMAND" "DEBUG_WRITE_CONFIGURATION" 02\n",
-				"  "SHOW_CHIP_INFORMATION"\n",
-				"  "EXECUTE_INSTRUCTION" <instruction bytes>\n",
-				"  "READ_MEMORY" <address:size> [output]\n"
+						"      " DEBUG_ERASE_FLASH ", erase flash\n"
+						"      " DEBUG_WRITE_CONFIGURATION ", write debug configuration data\n"
+						"      " DEBUG_READ_CONFIGURATION ", read debug configuration data\n"
+						"      " DEBUG_GET_PC ", get value of program counter\n"
+						"      " DEBUG_READ_STATUS ", read debug status\n"
+						"      " DEBUG_SET_BREAKPOINT ", set breakpoint\n"
+						"      " DEBUG_HALT_CPU ", halt CPU operation\n"
+						"      " DEBUG_RESUME_CPU ", resume CPU operation\n"
+						"      " DEBUG_RUN_INSTRUCTION ", run debug instruction\n"
+						"      " DEBUG_STEP_CPU ", step CPU instruction\n"
+						"      " DEBUG_GET_BM ", get memory bank\n"
+						"      " DEBUG_GET_ID ", get chip ID\n"
+						"      " DEBUG_BURST_WRITE ", perform burst write operation\n"
+						"    e.g. " EXECUTE_DEBUG_COMMAND " " DEBUG_WRITE_CONFIGURATION " 02\n",
+				"  " SHOW_CHIP_INFORMATION "\n",
+				"  " EXECUTE_INSTRUCTION " <instruction bytes>\n",
+				"  " READ_MEMORY " <address:size> [output]\n"
 						"    output:\n"
 						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file>, simple binary file format (see intelhex.h)\n"
 						"      raw <file>, data-only binary file\n",
-				"  "WRITE_MEMORY" <input> [\"verify\"]\n"
+				"  " WRITE_MEMORY " <input> [\"verify\"]\n"
 						"    input:\n"
 						"      dat <data bytes> <address>\n"
 						"      hex <file> [address:size], intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file> [address:size], simple binary file format (see intelhex.h)\n"
 						"      raw <file> <address[:size]> [file offset], data-only binary file\n",
-				"  "READ_FLASH_PAGE" <page> [output]\n"
+				"  " READ_FLASH_PAGE " <page> [output]\n"
 						"    output:\n"
 						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file>, simple binary file format (see intelhex.h)\n"
 						"      raw <file>, data-only binary file\n",
-				"  "WRITE_FLASH_PAGE" <page> <input> [\"verify\"]\n"
+				"  " WRITE_FLASH_PAGE " <page> <input> [\"verify\"]\n"
 						"    input:\n"
 						"      dat <data bytes> <address>\n"
 						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file>, simple binary file format (see intelhex.h)\n"
 						"      raw <file> [file offset], data-only binary file\n",
-				"  "ERASE_FLASH_PAGE" <page>\n",
-				"  "CHECK_FLASH_PAGE" <page>\n",
-				"  "LOCK_FLASH_PAGES" <page> [items]\n",
-				"  "UNLOCK_FLASH_PAGES" <page> [items]\n",
-				"  "READ_FLASH" <address:size> [output]\n"
+				"  " ERASE_FLASH_PAGE " <page>\n",
+				"  " CHECK_FLASH_PAGE " <page>\n",
+				"  " LOCK_FLASH_PAGES " <page> [items]\n",
+				"  " UNLOCK_FLASH_PAGES " <page> [items]\n",
+				"  " READ_FLASH " <address:size> [output]\n"
 						"    output:\n"
 						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file>, simple binary file format (see intelhex.h)\n"
 						"      raw <file>, data-only binary file\n",
-				"  "WRITE_FLASH" <input> [\"verify\"]\n"
+				"  " WRITE_FLASH " <input> [\"verify\"]\n"
 						"    input:\n"
 						"      dat <data bytes> <address>\n"
 						"      hex <file> [address:size], intel hexadecimal object file format (see intelhex.h)\n"
 						"      bin <file> [address:size], simple binary file format (see intelhex.h)\n"
-						"      raw <file> <address[:size]> [file offset], data-only binary file\n",
-				"  "ERASE_FLASH"\n",
-				"  "LOCK_DEBUG_INTERFACE"\n"
+						"      raw <file> <address[:size]> [file offset], data-only binary file\n"
+						"      img <file>, image file format with a page map (see intelhex.h); pages whose\n"
+						"        CRC16 differs from the chip's are erased and rewritten whole, and\n"
+						"        matching pages are skipped\n",
+				"  " ERASE_FLASH "\n",
+				"  " LOCK_DEBUG_INTERFACE "\n",
+				"  " RUN_FROM_SRAM " <input> [entry address] [\"verify\"]\n"
+						"    input:\n"
+						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
+						"      bin <file>, simple binary file format (see intelhex.h)\n"
+						"    note: image is linked for CODE addresses in the SRAM window, below the IDATA\n"
+						"      mirror in its last 256 bytes; entry address defaults to the file's start\n"
+						"      address or else its lowest address\n",
+				"  " PROFILE " <samples per second> <seconds> [symbol files]\n"
+						"    symbol files:\n"
+						"      SDCC .map, .rst, or .cdb files to resolve samples into functions\n"
+						"    note: the CPU is started from reset\n",
+				"  " TRACE " <instructions> <trace file> [address:size] [symbol files]\n"
+						"    address:size:\n"
+						"      code range to trace; stops at the first program counter outside it\n"
+						"    symbol files:\n"
+						"      SDCC .map, .rst, or .cdb files to resolve basic blocks into functions\n"
+						"    note: the CPU is run from reset to the start of the range, if reset is\n"
+						"      outside it, and stepped from there\n",
+				"  " TIME_FUNCTIONS " <calls> <timer> <functions> [symbol files]\n"
+						"    timer:\n"
+						"      t1, Timer 1 in free-running mode, stopped while the CPU is halted;\n"
+						"        firmware must not use Timer 1\n"
+						"      st, sleep timer at 32.768 kHz, includes breakpoint handling\n"
+						"    functions:\n"
+						"      up to 2 comma-separated function names (needs .cdb symbols),\n"
+						"      or entry:exit pairs of code addresses with exit being the return instruction\n"
+						"    note: the CPU is started from reset\n",
+				"  " DRAIN_LOG " <address> <milliseconds> <seconds> [output file]\n"
+						"    address:\n"
+						"      XDATA address of the firmware's log channel header (see ccdbg.h)\n"
+						"    milliseconds:\n"
+						"      interval between drains; a full drain is followed by another right away\n"
+						"    output file:\n"
+						"      file to append the log to instead of stdout\n"
+						"    note: the CPU is started from reset\n",
+				"  " SAMPLE_VARIABLES " <samples per second> <seconds> <csv file> <variables> [.cdb files]\n"
+						"    variables:\n"
+						"      up to 32 comma-separated XDATA variable names (needs .cdb files),\n"
+						"      or address:type pairs with type being u8, s8, u16, s16, u32, s32, or f32\n"
+						"    note: the CPU is started from reset; all variables are read in the same\n"
+						"      halt window\n",
+				"  " STACK_USAGE " <address:size> <seconds> [paint address] [symbol files]\n"
+						"    address:size:\n"
+						"      XDATA range of the stack, growing upwards; IDATA is at 0x1f00 ~ 0x1fff\n"
+						"    paint address:\n"
+						"      code address or function name (needs symbol files) to stop at before\n"
+						"        painting, e.g. main, as SDCC's start-up code clears IDATA;\n"
+						"        defaults to painting at reset\n"
+						"    symbol files:\n"
+						"      SDCC .map, .rst, or .cdb files to resolve the paint address\n"
+						"    note: the CPU is started from reset; IDATA at or below SP is not painted\n",
+				"  " TAKE_SNAPSHOT " <snapshot file> <stop address> [symbol files]\n"
+						"    stop address:\n"
+						"      code address or function name (needs symbol files) to take the snapshot at\n"
+						"    note: the CPU is started from reset; SRAM, SFRs, and the program counter are\n"
+						"      saved, XREGs (radio, USB, flash controller, etc.) are not\n",
+				"  " RESTORE_SNAPSHOT " <snapshot file>\n"
+						"    note: SFRs with side effects (FIFOs, strobes, counters, DMA arming, and\n"
+						"      the like) are not restored; the CPU is resumed at the snapshot's program\n"
+						"      counter\n",
+				"  " GDB_SERVER " <port | socket path>\n"
+						"    port:\n"
+						"      TCP port on the loopback interface, e.g. 3333\n"
+						"    socket path:\n"
+						"      path of a Unix socket\n"
+						"    note: the CPU is halted at reset; flash is at 0x000000 and XDATA at\n"
+						"      0x800000, see gdbserver.h for the registers\n",
+				"  " WAIT_FOR_HALT " <stop address> [milliseconds] [symbol files]\n"
+						"    stop address:\n"
+						"      code address or function name (needs symbol files) to set a breakpoint at\n"
+						"    milliseconds:\n"
+						"      time to wait for the breakpoint, defaults to waiting for as long as it takes\n"
+						"    note: the CPU is started from reset and left halted at the breakpoint\n",
+				"  " DIGEST " <input>\n"
+						"    input:\n"
+						"      hex <file>, intel hexadecimal object file format (see intelhex.h)\n"
+						"      bin <file>, simple binary file format (see intelhex.h)\n"
+						"    note: CRC16 of each flash page of the file is compared with the CRC16\n"
+						"      computed by the chip; nothing is read back from flash\n"
 };
 
 static void printBytes(unsigned int address, unsigned int size, const unsigned char *data)
@@ -402,13 +565,27 @@ static int parseReadArgs(int argc, char **argv, unsigned int *address, unsigned
 
 static void saveReadData(int argc, char **argv, unsigned int address, unsigned int size, int fileFormat, IntelHex *intelHex, FILE *file, const unsigned char *buffer)
 {
+	IntelHexWriter writer;
 	int okay;
 
 	if(argc == 3)
 		printBytes(address, size, buffer);
 	else
 	{
-		if(file == NULL)
+		if(file == NULL && intelHex->memory == NULL)
+		{
+			/**
+			 * nothing to merge with, so the data is encoded straight to file
+			 */
+			if((okay = (intelHex_openWriter(&writer, fileFormat, argv[4], address + size - 1, 0) == 0)))
+			{
+				okay = (intelHex_writeData(&writer, address, buffer, size) == 0);
+
+				if(intelHex_closeWriter(&writer) != 0)
+					okay = 0;
+			}
+		}
+		else if(file == NULL)
 		{
 			if((okay = (intelHex_saveDataToHexInfo(intelHex, buffer, NULL, size, address) == 0)))
 				okay = (intelHex_convert(0, NULL, intelHex, fileFormat, argv[4], NULL, INTEL_HEX_IGNORE_UNKNOWN_RECORD) == 0);
@@ -420,9 +597,8 @@ static void saveReadData(int argc, char **argv, unsigned int address, unsigned i
 	}
 }
 
-static int parseWriteArgs(int argc, char **argv, unsigned int *address, unsigned int *size, unsigned int *page, int *verify, IntelHex *intelHex, FILE **file, unsigned char **buffer, IntelHexMemory **intelHexMemory)
+static int parseWriteArgs(int argc, char **argv, unsigned int *address, unsigned int *size, unsigned int *page, int *verify, IntelHex *intelHex, unsigned char **buffer, const unsigned char **data, IntelHexMemory **intelHexMemory)
 {
-	long fileSize;
 	int fileFormat;
 	unsigned int offset;
 	int arg;
@@ -467,28 +643,18 @@ static int parseWriteArgs(int argc, char **argv, unsigned int *address, unsigned
 		}
 		else if((unsigned int)i != *size)
 			return -1;
+
+		*data = *buffer;
 	}
 	else if(strcmp(argv[arg], "raw") == 0)
 	{
 		if(argc < 5 || argc > 6)
 			return -1;
 
-		if((*file = fopen(argv[arg + 1], "rb")) == NULL)
-			return -1;
-
-		if(fseek(*file, 0, SEEK_END) != 0)
-			return -1;
-
-		if((fileSize = ftell(*file)) < 1)
-			return -1;
-
 		if(argc == 6)
 		{
 			if(stringToNumber(argv[arg + 2 + (page == NULL)], &offset, "") != 0)
 				return -1;
-
-			if((long)offset >= fileSize)
-				return -1;
 		}
 		else
 			offset = 0;
@@ -504,20 +670,17 @@ static int parseWriteArgs(int argc, char **argv, unsigned int *address, unsigned
 					return -1;
 			}
 			else
-				*size = fileSize - offset;
+				*size = 0;
 		}
 
-		if(*size > (fileSize - offset))
-			return -1;
-
-		if(fseek(*file, offset, SEEK_SET) != 0)
-			return -1;
-
-		if((*buffer = (unsigned char *)malloc(*size)) == NULL)
+		if(intelHex_readRawFile(argv[arg + 1], offset, *size, *address, intelHex, 0) != 0)
 			return -1;
 
-		if(fread(*buffer, 1, *size, *file) != *size)
-			return -1;
+		/**
+		 * note: the data is written straight from the mapping of the file
+		 */
+		*size = intelHex->memory->size;
+		*data = intelHex->memory->data;
 	}
 	else
 	{
@@ -555,436 +718,2499 @@ static int parseWriteArgs(int argc, char **argv, unsigned int *address, unsigned
 			*intelHexMemory = intelHex->memory->next;
 		}
 
-		if((*buffer = (unsigned char *)malloc(*size)) == NULL)
-			return -1;
-
-		if(intelHex_copyDataFromHexInfo(intelHex, *address, *buffer, NULL, *size) != 0)
+		/**
+		 * note: the data is written straight from the image, without copying
+		 */
+		if((*data = intelHex_getData(intelHex, *address, *size)) == NULL)
 			return -1;
 	}
 
 	return 0;
 }
 
-int main(int argc, char **argv)
-{
-	int okay = 0;
-	unsigned char *buffer = NULL;
-	FILE *file = NULL;
-	IntelHexMemory *intelHexMemory = NULL;
-	IntelHex intelHex;
-	CCDBG_INFO info;
-	unsigned int address;
-	unsigned int size;
+/**
+ * flash page assembled from hex records
+ */
+typedef struct {
 	unsigned int page;
-	unsigned int count;
-	int fileFormat;
-	int verify;
-	int command;
-	int debugCommand;
-	int result;
+	unsigned char *data;
+	unsigned char *hasData;		/* non-zero for bytes that came from the file */
+} FlashPipelinePage;
 
-	if(argc < 2 || *argv[1] != '-' || strlen(argv[1]) != 3)
-		command = UNKNOWN_COMMAND;
-	else
-		for(command = COMMAND_ITEMS; --command > UNKNOWN_COMMAND && memcmp(argv[1], commandList[command], 3) != 0; );
+/**
+ * pages passed from the thread parsing the hex file to the one writing flash
+ */
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	FlashPipelinePage pages[FLASH_PIPELINE_PAGES];
+	unsigned int filledPages;	/* pages handed to the writer */
+	unsigned int writtenPages;	/* pages done by the writer */
+	int isFilling;				/* the page after the filled ones has data */
+	int isDone;					/* parsing ended */
+	int isCancelled;			/* writing failed */
+	int status;					/* of parsing */
+	const char *filename;
+	unsigned int pageSize;
+	unsigned int flashSize;
+	unsigned char *flashData;	/* page read from flash to fill the gaps */
+	unsigned int nextAddress;	/* records must go up from here */
+	int isInOrder;
+	unsigned int bytes;
+} FlashPipeline;
+
+static int checkFlashData(void *context, uint32_t address, const uint8_t *data, uint32_t size)
+{
+	FlashPipeline *pipeline = (FlashPipeline *)context;
 
-	if(command == UNKNOWN_COMMAND)
+	if(address < pipeline->nextAddress || address >= pipeline->flashSize || size > (pipeline->flashSize - address))
 	{
-		printf("\n"
-				"  %s <command> [args]\n"
-				"    "EXECUTE_DEBUG_COMMAND", execute debug command\n"
-				"    "SHOW_CHIP_INFORMATION", show chip information\n"
-				"    "EXECUTE_INSTRUCTION", execute instruction\n"
-				"    "READ_MEMORY", read memory\n"
-				"    "WRITE_MEMORY", write memory\n"
-				"    "READ_FLASH_PAGE", read flash page\n"
-				"    "WRITE_FLASH_PAGE", write flash page\n"
-				"    "ERASE_FLASH_PAGE", erase flash page\n"
-				"    "CHECK_FLASH_PAGE", check if flash page is locked\n"
-				"    "LOCK_FLASH_PAGES", lock flash pages\n"
-				"    "UNLOCK_FLASH_PAGES", unlock flash pages\n"
-				"    "READ_FLASH", read flash\n"
-				"    "WRITE_FLASH", write flash\n"
-				"    "ERASE_FLASH", erase flash\n"
-				"    "LOCK_DEBUG_INTERFACE", lock debug interface\n"
-				"\n",
-				argv[0]);
-
+		pipeline->isInOrder = 0;
 		return -1;
 	}
 
-	intelHex_initializeHexInfo(&intelHex, 0);
+	pipeline->nextAddress = address + size;
+	pipeline->bytes += size;
 
-	printf("\n");
+	return 0;
+}
 
-	do
+static int fillFlashPages(void *context, uint32_t address, const uint8_t *data, uint32_t size)
+{
+	FlashPipeline *pipeline = (FlashPipeline *)context;
+	FlashPipelinePage *page = &pipeline->pages[pipeline->filledPages % FLASH_PIPELINE_PAGES];
+	unsigned int offset;
+	unsigned int length;
+	int isCancelled;
+
+	while(size > 0)
 	{
-		if(ccdbgDevice_initialize() != 0)
+		if(pipeline->isFilling && page->page != (address / pipeline->pageSize))
 		{
-			printf("FAILED to initialize the ccdbg device\n");
-			break;
+			pthread_mutex_lock(&pipeline->mutex);
+			pipeline->filledPages++;
+			pipeline->isFilling = 0;
+			pthread_cond_broadcast(&pipeline->condition);
+			pthread_mutex_unlock(&pipeline->mutex);
 		}
 
-		if(ccdbg_identifyChip(&info) == CCDBG_INVALID_ID)
+		if(!pipeline->isFilling)
 		{
-			printf("FAILED to identify the chip\n");
-			break;
-		}
+			pthread_mutex_lock(&pipeline->mutex);
 
-		if(info.isLocked)
-		{
-			if(command != COMMAND_SHOW_CHIP_INFORMATION && command != COMMAND_ERASE_FLASH)
-			{
-				printf("FAILED: chip is LOCKED -- only \""SHOW_CHIP_INFORMATION"\" and \""ERASE_FLASH"\" commands are available\n");
-				break;
-			}
-		}
+			while((pipeline->filledPages - pipeline->writtenPages) == FLASH_PIPELINE_PAGES && !pipeline->isCancelled)
+				pthread_cond_wait(&pipeline->condition, &pipeline->mutex);
 
-		switch(command)
-		{
-		case COMMAND_EXECUTE_DEBUG_COMMAND:
+			isCancelled = pipeline->isCancelled;
+			pthread_mutex_unlock(&pipeline->mutex);
 
-			if(argc < 3 || argc > 4 || strlen(argv[2]) != 2)
-				break;
+			if(isCancelled)
+				return -1;
 
-			for(debugCommand = DEBUG_COMMAND_ITEMS; --debugCommand > UNKNOWN_DEBUG_COMMAND && memcmp(argv[2], debugCommandList[debugCommand].string, 2) != 0; );
+			page = &pipeline->pages[pipeline->filledPages % FLASH_PIPELINE_PAGES];
+			page->page = address / pipeline->pageSize;
+			memset(page->hasData, 0, pipeline->pageSize);
+			pipeline->isFilling = 1;
+		}
 
-			if(debugCommand == UNKNOWN_DEBUG_COMMAND)
-				break;
+		offset = address % pipeline->pageSize;
 
-			if(debugCommandList[debugCommand].minimumInputBytes > 0)
-			{
-				if(argc != 4)
-					break;
+		if((length = pipeline->pageSize - offset) > size)
+			length = size;
 
-				if((int)(size = hexStringToBytes(&buffer, argv[3])) < 1)
-					break;
+		memcpy(&page->data[offset], data, length);
+		memset(&page->hasData[offset], 1, length);
 
-				if(size < debugCommandList[debugCommand].minimumInputBytes || size > debugCommandList[debugCommand].maximumInputBytes)
-					break;
-			}
-			else
-			{
-				if(argc != 3)
-					break;
+		address += length;
+		data += length;
+		size -= length;
+	}
 
-				size = 0;
-			}
+	return 0;
+}
 
-			printf("executing debug command...\n");
+static void * parseFlashPages(void *argument)
+{
+	FlashPipeline *pipeline = (FlashPipeline *)argument;
+	int status;
 
-			result = ccdbg_command(debugCommandList[debugCommand].id, size, buffer, &size, NULL, 1);
-			okay = (result >= 0);
+	status = intelHex_streamHexFile(pipeline->filename, INTEL_HEX_IGNORE_UNKNOWN_RECORD, fillFlashPages, pipeline);
 
-			printf("\n>> ");
+	pthread_mutex_lock(&pipeline->mutex);
 
-			if(okay)
-			{
-				printf("debug command output is %.2x", ((unsigned char *)&result)[0]);
+	if(pipeline->isFilling)
+		pipeline->filledPages++;
 
-				if(size > 1)
-					printf(" %.2x", ((unsigned char *)&result)[1]);
+	pipeline->isFilling = 0;
+	pipeline->isDone = 1;
+	pipeline->status = status;
+	pthread_cond_broadcast(&pipeline->condition);
+	pthread_mutex_unlock(&pipeline->mutex);
 
-				printf("\n");
-			}
-			else
-				printf("FAILED\n");
+	return NULL;
+}
 
-			goto done;
+static int writeFlashPipelinePage(CCDBG_ID id, const FlashPipeline *pipeline, const FlashPipelinePage *page, int verify)
+{
+	const unsigned char *data = page->data;
+	unsigned int address;
+	unsigned int size;
+	int changed = 0;
+	unsigned int i;
 
-		case COMMAND_SHOW_CHIP_INFORMATION:
+	/**
+	 * note: the gaps of a page are filled from flash, through the page cache,
+	 *       so the page is still written once and keeps its contents there;
+	 *       a page that comes out the same as flash is not written
+	 */
 
-			if(argc != 2)
-				break;
+	for(i = 0; i < pipeline->pageSize && page->hasData[i]; i++);
 
-			printf("  chip info:\n"
-					"    id: 0x%.2x\n"
-					"    revision: 0x%.2x\n"
-					"    flash size: %u bytes (%.1fKB)\n"
-					"    writable flash size: %u bytes (%.1fKB)\n"
-					"    flash bank size: %u bytes (%.1fKB)\n"
-					"    flash page size: %u bytes (%.1fKB)\n"
-					"    number of flash pages: %u\n"
-					"    SRAM size: %u bytes (%.1fKB)\n"
-					"    locked: %s\n"
-					"    IEEE address: ",
-					info.id,
-					info.rev,
-					info.flashSize, KB(info.flashSize),
-					info.writableFlashSize, KB(info.writableFlashSize),
-					info.flashBankSize, KB(info.flashBankSize),
-					info.flashPageSize, KB(info.flashPageSize),
-					info.numberOfFlashPages,
-					info.sramSize, KB(info.sramSize),
-					info.isLocked ? "yes" : "no");
+	if(i < pipeline->pageSize)
+	{
+		if(ccdbg_readFlashPage(id, page->page, pipeline->flashData) != 0)
+			return -1;
 
-			if(info.ieeeAddressLength == 0)
-				printf("n/a\n");
-			else
+		for(i = 0; i < pipeline->pageSize; i++)
+		{
+			if(page->hasData[i] && pipeline->flashData[i] != page->data[i])
 			{
-				int i;
-
-				for(i = (int)info.ieeeAddressLength; i-- > 0; )
-					printf("%.2x", info.ieeeAddress[i]);
-
-				printf("\n");
+				pipeline->flashData[i] = page->data[i];
+				changed = 1;
 			}
+		}
 
-			okay = 1;
-			goto done;
+		if(!changed)
+			return 0;
 
-		case COMMAND_EXECUTE_INSTRUCTION:
+		data = pipeline->flashData;
+	}
 
-			if(argc != 3)
-				break;
+	/**
+	 * the lock bits at the end of the last page are left out of the write
+	 */
+	address = page->page * pipeline->pageSize;
+	size = ((pipeline->flashSize - address) < pipeline->pageSize) ? (pipeline->flashSize - address) : pipeline->pageSize;
 
-			if((int)(size = hexStringToBytes(&buffer, argv[2])) < 1)
-				break;
+	if(ccdbg_writeFlash(id, address, size, data, verify) != (int)size)
+		return -1;
 
-			printf("executing instruction...\n"
-					"  code: %s\n", argv[2]);
+	return 0;
+}
 
-			result = ccdbg_executeInstruction(&info, size, buffer);
-			okay = (result >= 0);
+static int writeFlashFromHexFile(CCDBG_ID id, const char *filename, int verify, int *isStreamable)
+{
+	FlashPipeline pipeline;
+	FlashPipelinePage *page;
+	unsigned char *buffer;
+	pthread_t thread;
+	int status = 0;
+	int i;
 
-			printf("\n>> ");
+	/**
+	 * records are checked in a first pass, which is quick next to writing
+	 * flash, so a bad file leaves flash untouched; then one thread parses
+	 * the file into pages while this one writes them, holding no more than
+	 * FLASH_PIPELINE_PAGES pages at a time
+	 *
+	 * note: files with records out of order or past the writable flash are
+	 *       left to the caller to load whole
+	 */
+
+	memset(&pipeline, 0, sizeof(pipeline));
+	pipeline.filename = filename;
+	pipeline.pageSize = id->flashPageSize;
+	pipeline.flashSize = id->writableFlashSize;
+	pipeline.isInOrder = 1;
+
+	if(intelHex_streamHexFile(filename, INTEL_HEX_IGNORE_UNKNOWN_RECORD, checkFlashData, &pipeline) != 0)
+	{
+		*isStreamable = pipeline.isInOrder;
+		return -1;
+	}
 
-			if(okay)
-				printf("resulting accumulator register value is 0x%.2x\n", result);
-			else
-				printf("FAILED\n");
+	*isStreamable = 1;
 
-			goto done;
+	if(pipeline.bytes < 1)
+		return 0;
 
-		case COMMAND_ERASE_FLASH_PAGE:
+	if((buffer = (unsigned char *)malloc((FLASH_PIPELINE_PAGES * 2 + 1) * pipeline.pageSize)) == NULL)
+		return -1;
 
-			if(argc != 3)
-				break;
+	pipeline.flashData = &buffer[FLASH_PIPELINE_PAGES * pipeline.pageSize * 2];
 
-			if(stringToNumber(argv[2], &page, "") != 0)
-				break;
+	for(i = 0; i < FLASH_PIPELINE_PAGES; i++)
+	{
+		pipeline.pages[i].data = &buffer[i * pipeline.pageSize * 2];
+		pipeline.pages[i].hasData = &pipeline.pages[i].data[pipeline.pageSize];
+	}
 
-			printf("erasing flash page %d...\n", page);
+	pthread_mutex_init(&pipeline.mutex, NULL);
+	pthread_cond_init(&pipeline.condition, NULL);
 
-			result = ccdbg_eraseFlashPage(&info, page);
-			okay = (result == 0);
+	if(pthread_create(&thread, NULL, parseFlashPages, &pipeline) != 0)
+		status = -1;
 
-			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+	while(status == 0)
+	{
+		pthread_mutex_lock(&pipeline.mutex);
 
-			goto done;
+		while(pipeline.writtenPages == pipeline.filledPages && !pipeline.isDone)
+			pthread_cond_wait(&pipeline.condition, &pipeline.mutex);
 
-		case COMMAND_CHECK_FLASH_PAGE:
+		page = (pipeline.writtenPages == pipeline.filledPages) ? NULL : &pipeline.pages[pipeline.writtenPages % FLASH_PIPELINE_PAGES];
+		pthread_mutex_unlock(&pipeline.mutex);
 
-			if(argc != 3)
-				break;
+		if(page == NULL)
+			break;
 
-			if(stringToNumber(argv[2], &page, "") != 0)
-				break;
+		status = writeFlashPipelinePage(id, &pipeline, page, verify);
 
-			printf("checking if flash page is locked...\n"
-					"  page: %d\n",
-					page);
+		pthread_mutex_lock(&pipeline.mutex);
 
-			result = ccdbg_isFlashPageLocked(&info, page);
-			okay = (result >= 0);
+		if(status == 0)
+			pipeline.writtenPages++;
+		else
+			pipeline.isCancelled = 1;
 
-			printf("\n>> ");
+		pthread_cond_broadcast(&pipeline.condition);
+		pthread_mutex_unlock(&pipeline.mutex);
+	}
 
-			if(okay)
-				printf("flash page is %s\n", (result == 0) ? "NOT LOCKED" : "LOCKED");
-			else
-				printf("FAILED\n");
+	if(status == 0 || pipeline.isCancelled)
+	{
+		pthread_join(thread, NULL);
 
-			goto done;
+		if(status == 0)
+			status = pipeline.status;
+	}
 
-		case COMMAND_LOCK_FLASH_PAGES:
-		case COMMAND_UNLOCK_FLASH_PAGES:
+	pthread_cond_destroy(&pipeline.condition);
+	pthread_mutex_destroy(&pipeline.mutex);
+	free(buffer);
 
-			if(argc < 3 || argc > 4)
-				break;
+	return (status == 0) ? (int)pipeline.bytes : -1;
+}
 
-			if(stringToNumber(argv[2], &page, "") != 0)
-				break;
+static int writeFlashFromImageFile(CCDBG_ID id, const char *filename, int verify, unsigned int *writtenPages, unsigned int *erasedPages, unsigned int *unchangedPages)
+{
+	IntelHexImage image;
+	IntelHexPage imagePage;
+	unsigned int page;
+	int crc;
+	int status = 0;
+
+	/**
+	 * the image comes with the CRC16 and blank flag of each page, so the
+	 * chip's own CRC16 of a page decides whether it is written, erased, or
+	 * left alone, without reading flash back or parsing the file
+	 *
+	 * note: pages are written whole; bytes without data in the file the
+	 *       image was made from are erased
+	 */
+
+	*writtenPages = 0;
+	*erasedPages = 0;
+	*unchangedPages = 0;
+
+	if(intelHex_openImage(filename, &image) != 0)
+	{
+		printf("FAILED to open the image file\n");
+		return -1;
+	}
 
-			if(argc == 4)
+	printf("  chip ID: 0x%.2x%s\n"
+			"  page size: %u\n"
+			"  pages: %u with data, from page %u\n\n",
+			image.chipId, (image.chipId == 0) ? " (any chip)" : "", image.pageSize, image.digest.page, image.firstPage);
+
+	if(image.chipId != 0 && image.chipId != id->id)
+	{
+		printf("FAILED: image is for chip ID 0x%.2x, not 0x%.2x\n", image.chipId, id->id);
+		status = -1;
+	}
+	else if(image.pageSize != id->flashPageSize)
+	{
+		printf("FAILED: image has %u-byte pages, flash has %u-byte pages\n", image.pageSize, id->flashPageSize);
+		status = -1;
+	}
+	else if(image.numberOfPages > 0 && ((uint64_t)image.firstPage + image.numberOfPages) * image.pageSize > id->writableFlashSize)
+	{
+		printf("FAILED: image is past the writable flash\n");
+		status = -1;
+	}
+
+	for(page = image.firstPage; status == 0 && (page - image.firstPage) < image.numberOfPages; page++)
+	{
+		if((status = intelHex_getImagePage(&image, page, &imagePage)) != 0)
+		{
+			status = (status < 0) ? -1 : 0;
+			continue;
+		}
+
+		if((crc = ccdbg_getFlashPageCrc(id, page)) < 0)
+			status = -1;
+		else if(crc == imagePage.crc)
+			++*unchangedPages;
+		else if((imagePage.flags & INTEL_HEX_PAGE_BLANK))
+		{
+			status = ccdbg_eraseFlashPage(id, page);
+			++*erasedPages;
+		}
+		else
+		{
+			status = ccdbg_writeFlashPage(id, page, imagePage.data, verify);
+			++*writtenPages;
+		}
+
+		if(status != 0)
+			printf("FAILED at page %u\n", page);
+	}
+
+	intelHex_closeImage(&image);
+	return status;
+}
+
+static int startCpu(CCDBG_ID id)
+{
+	/**
+	 * the chip has been halted at reset by ccdbg_identifyChip
+	 */
+	if(ccdbg_resume(id) != 0)
+	{
+		printf("\n>> FAILED to start the CPU\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+typedef struct {
+	unsigned int samples;
+	uint64_t duration;
+	uint64_t haltTime;			/* sum of the halt windows */
+	uint64_t maximumHaltTime;
+} SamplingStatistics;
+
+/**
+ * a sample halts the CPU, takes what it needs, and resumes the CPU, which
+ *   is timed as its halt window; it returns less than zero for error
+ */
+typedef int (*SampleFunction)(CCDBG_ID id, void *context);
+
+/**
+ * a record keeps the result of a sample taken at time, in microseconds
+ *   from the start of sampling; it returns non-zero to take the next sample
+ *   at once
+ */
+typedef int (*RecordFunction)(uint64_t time, int result, void *context);
+
+static int sampleAtInterval(CCDBG_ID id, unsigned int interval, unsigned int seconds, SampleFunction sample, RecordFunction record, void *context, SamplingStatistics *statistics)
+{
+	uint64_t startTime;
+	uint64_t sampleTime;
+	uint64_t nextTime;
+	uint64_t now;
+	int status = 0;
+	int result;
+
+	memset(statistics, 0, sizeof(SamplingStatistics));
+	startTime = nextTime = ccdbgDevice_getMicroseconds();
+
+	while((now = ccdbgDevice_getMicroseconds()) - startTime < (uint64_t)seconds * 1000000)
+	{
+		if(now < nextTime)
+		{
+			usleep(nextTime - now);
+			continue;
+		}
+
+		if((result = sample(id, context)) < 0)
+		{
+			status = -1;
+			break;
+		}
+
+		sampleTime = ccdbgDevice_getMicroseconds();
+		statistics->haltTime += sampleTime - now;
+		++statistics->samples;
+
+		if(sampleTime - now > statistics->maximumHaltTime)
+			statistics->maximumHaltTime = sampleTime - now;
+
+		/**
+		 * a record may ask for the next sample at once; otherwise fall
+		 *   behind rather than sample in bursts to catch up
+		 */
+		if(record(now - startTime, result, context) || (nextTime += interval) < sampleTime)
+			nextTime = sampleTime;
+	}
+
+	statistics->duration = now - startTime;
+	return status;
+}
+
+static int samplePc(CCDBG_ID id, void *context)
+{
+	return ccdbg_samplePc(id);
+}
+
+static int recordPc(uint64_t time, int result, void *context)
+{
+	unsigned int *histogram = (unsigned int *)context;
+
+	++histogram[result];
+	return 0;
+}
+
+typedef struct {
+	unsigned int address;
+	unsigned char *buffer;
+	FILE *file;
+	unsigned int bytes;
+} LogDrain;
+
+static int drainLog(CCDBG_ID id, void *context)
+{
+	LogDrain *drain = (LogDrain *)context;
+
+	return ccdbg_drainLog(id, drain->address, LOG_MAXIMUM_DRAIN_SIZE, drain->buffer);
+}
+
+static int recordLog(uint64_t time, int result, void *context)
+{
+	LogDrain *drain = (LogDrain *)context;
+
+	if(result > 0)
+	{
+		drain->bytes += result;
+		fwrite(drain->buffer, 1, result, drain->file);
+		fflush(drain->file);
+	}
+
+	/**
+	 * a full drain likely left more behind
+	 */
+	return (result == LOG_MAXIMUM_DRAIN_SIZE);
+}
+
+typedef struct {
+	unsigned int samples;
+	unsigned int address;
+	const char *name;
+} ProfileEntry;
+
+static int compareProfileEntries(const void *a, const void *b)
+{
+	const ProfileEntry *entryA = (const ProfileEntry *)a;
+	const ProfileEntry *entryB = (const ProfileEntry *)b;
+
+	if(entryA->samples != entryB->samples)
+		return (entryA->samples > entryB->samples) ? -1 : 1;
+
+	return (entryA->address < entryB->address) ? -1 : (entryA->address > entryB->address);
+}
+
+static int printProfile(const unsigned int *histogram, unsigned int samples, const SdccSymbols *symbols)
+{
+	ProfileEntry *entries;
+	const SdccSymbol *symbol;
+	unsigned int numberOfEntries;
+	unsigned int unresolved = 0;
+	unsigned int i;
+
+	/**
+	 * one entry per symbol, or per program counter value if there are no symbols
+	 */
+	numberOfEntries = (symbols->numberOfSymbols > 0) ? symbols->numberOfSymbols : PROFILE_HISTOGRAM_SIZE;
+
+	if((entries = (ProfileEntry *)calloc(numberOfEntries, sizeof(ProfileEntry))) == NULL)
+		return -1;
+
+	for(i = 0; i < numberOfEntries; i++)
+	{
+		entries[i].address = (symbols->numberOfSymbols > 0) ? symbols->symbols[i].address : i;
+		entries[i].name = (symbols->numberOfSymbols > 0) ? symbols->symbols[i].name : NULL;
+	}
+
+	for(i = 0; i < PROFILE_HISTOGRAM_SIZE; i++)
+	{
+		if(histogram[i] == 0)
+			continue;
+
+		if(symbols->numberOfSymbols == 0)
+			entries[i].samples = histogram[i];
+		else if((symbol = sdcc_findSymbol(symbols, i)) != NULL)
+			entries[symbol - symbols->symbols].samples += histogram[i];
+		else
+			unresolved += histogram[i];
+	}
+
+	qsort(entries, numberOfEntries, sizeof(ProfileEntry), compareProfileEntries);
+
+	printf("\n   samples        %%  address  %s\n"
+			"  ------------------------------------------------\n",
+			(symbols->numberOfSymbols > 0) ? "function" : "");
+
+	for(i = 0; i < numberOfEntries && i < PROFILE_MAXIMUM_ENTRIES && entries[i].samples > 0; i++)
+	{
+		printf("  %8u  %6.2f%%  0x%.4x  %s\n", entries[i].samples, (100.0 * entries[i].samples) / samples,
+				entries[i].address, (entries[i].name != NULL) ? entries[i].name : "");
+	}
+
+	if(unresolved > 0)
+		printf("  %8u  %6.2f%%          (no symbol)\n", unresolved, (100.0 * unresolved) / samples);
+
+	free(entries);
+	return 0;
+}
+
+/**
+ * trace file format (little-endian)
+ *
+ * offset         size (bytes)    description
+ * --------------------------------------------------------------------
+ * 0              4               "CCTR"
+ * 4              4               number of program counters
+ * 8              2               first program counter
+ * 10             1 or 3          second program counter; 1 byte of 0x01 ~ 0x03
+ *                                if the program counter advanced by that much,
+ *                                otherwise 0x00 followed by the program counter
+ * ...
+ * --------------------------------------------------------------------
+ */
+static int saveTrace(const char *filename, const unsigned short *pcs, unsigned int count)
+{
+	unsigned char record[8];
+	unsigned int recordSize;
+	unsigned int delta;
+	unsigned int i;
+	FILE *file;
+	int okay;
+
+	if((file = fopen(filename, "wb")) == NULL)
+		return -1;
+
+	memcpy(record, TRACE_SIGNATURE, 4);
+	record[4] = count & 0xff;
+	record[5] = (count >> 8) & 0xff;
+	record[6] = (count >> 16) & 0xff;
+	record[7] = (count >> 24) & 0xff;
+
+	okay = (fwrite(record, 1, 8, file) == 8);
+
+	for(i = 0; i < count && okay; i++)
+	{
+		delta = (i > 0) ? ((pcs[i] - pcs[i - 1]) & 0xffff) : 0;
+
+		if(delta >= 1 && delta <= 3)
+		{
+			record[0] = delta;
+			recordSize = 1;
+		}
+		else
+		{
+			record[0] = 0x00;
+			record[1] = pcs[i] & 0xff;
+			record[2] = (pcs[i] >> 8) & 0xff;
+			recordSize = 3;
+		}
+
+		/**
+		 * the first program counter goes without the 0x00 marker
+		 */
+		if(i == 0)
+			okay = (fwrite(&record[1], 1, 2, file) == 2);
+		else
+			okay = (fwrite(record, 1, recordSize, file) == recordSize);
+	}
+
+	if(fclose(file) != 0)
+		okay = 0;
+
+	return okay ? 0 : -1;
+}
+
+typedef struct {
+	unsigned int address;
+	unsigned int executions;
+	unsigned int instructions;
+} TraceBlock;
+
+static int compareTraceBlocks(const void *a, const void *b)
+{
+	const TraceBlock *blockA = (const TraceBlock *)a;
+	const TraceBlock *blockB = (const TraceBlock *)b;
+
+	if(blockA->instructions != blockB->instructions)
+		return (blockA->instructions > blockB->instructions) ? -1 : 1;
+
+	return (blockA->address < blockB->address) ? -1 : (blockA->address > blockB->address);
+}
+
+static int printTraceSummary(const unsigned short *pcs, unsigned int count, const SdccSymbols *symbols)
+{
+	TraceBlock *blocks;
+	const SdccSymbol *symbol;
+	unsigned int numberOfBlocks = 0;
+	unsigned int delta;
+	unsigned int leader = 0;
+	unsigned int i;
+
+	if((blocks = (TraceBlock *)calloc(PROFILE_HISTOGRAM_SIZE, sizeof(TraceBlock))) == NULL)
+		return -1;
+
+	/**
+	 * a basic block starts wherever the program counter did not just
+	 *   advance past a 1 to 3 byte instruction
+	 */
+	for(i = 0; i < count; i++)
+	{
+		delta = (i > 0) ? ((pcs[i] - pcs[i - 1]) & 0xffff) : 0;
+
+		if(delta < 1 || delta > 3)
+		{
+			leader = pcs[i];
+
+			if(blocks[leader].executions++ == 0)
+				++numberOfBlocks;
+		}
+
+		++blocks[leader].instructions;
+	}
+
+	for(i = 0; i < PROFILE_HISTOGRAM_SIZE; i++)
+		blocks[i].address = i;
+
+	qsort(blocks, PROFILE_HISTOGRAM_SIZE, sizeof(TraceBlock), compareTraceBlocks);
+
+	printf("\n   %u basic blocks\n\n"
+			"  executions  instructions  address  %s\n"
+			"  --------------------------------------------------------\n",
+			numberOfBlocks, (symbols->numberOfSymbols > 0) ? "function" : "");
+
+	for(i = 0; i < numberOfBlocks && i < PROFILE_MAXIMUM_ENTRIES; i++)
+	{
+		printf("  %10u  %12u  0x%.4x  ", blocks[i].executions, blocks[i].instructions, blocks[i].address);
+
+		if((symbol = sdcc_findSymbol(symbols, blocks[i].address)) != NULL)
+			printf("%s+0x%x", symbol->name, blocks[i].address - symbol->address);
+
+		printf("\n");
+	}
+
+	free(blocks);
+	return 0;
+}
+
+typedef struct {
+	char name[64];
+	unsigned int entryAddress;
+	unsigned int exitAddress;
+	unsigned int calls;
+	unsigned int overflows;
+	int inCall;
+	uint32_t start;
+	uint32_t minimum;
+	uint32_t maximum;
+	uint64_t total;
+} TimedFunction;
+
+static int parseTimedFunctions(char *string, const SdccSymbols *symbols, TimedFunction *functions)
+{
+	const SdccSymbol *symbol;
+	char *name;
+	int numberOfFunctions = 0;
+	int i;
+
+	for(name = strtok(string, ","); name != NULL; name = strtok(NULL, ","))
+	{
+		if(numberOfFunctions == TIMING_MAXIMUM_FUNCTIONS)
+			return -1;
+
+		memset(&functions[numberOfFunctions], 0, sizeof(TimedFunction));
+		snprintf(functions[numberOfFunctions].name, sizeof(functions[numberOfFunctions].name), "%s", name);
+
+		if(isdigit(name[0]))
+		{
+			if((i = stringToNumber(name, &functions[numberOfFunctions].entryAddress, ":")) < 1)
+				return -1;
+
+			if(stringToNumber(&name[i], &functions[numberOfFunctions].exitAddress, "") != 0)
+				return -1;
+		}
+		else
+		{
+			/**
+			 * the function's last byte is its return instruction
+			 */
+			if((symbol = sdcc_findSymbolByName(symbols, name)) == NULL || symbol->endAddress == 0)
+				return -1;
+
+			functions[numberOfFunctions].entryAddress = symbol->address;
+			functions[numberOfFunctions].exitAddress = symbol->endAddress - 1;
+		}
+
+		if(functions[numberOfFunctions].entryAddress == functions[numberOfFunctions].exitAddress)
+			return -1;
+
+		functions[numberOfFunctions].minimum = (uint32_t)-1;
+		++numberOfFunctions;
+	}
+
+	return numberOfFunctions;
+}
+
+static int readTargetTimer(CCDBG_ID id, int timer, uint32_t *ticks)
+{
+	unsigned char data[3];
+
+	if(timer == TIMER_1)
+	{
+		/**
+		 * reading T1CNTL latches T1CNTH
+		 */
+		if(ccdbg_readMemory(id, REG_T1CNTL, 2, data) < 0)
+			return -1;
+
+		*ticks = data[0] | (data[1] << 8);
+	}
+	else
+	{
+		/**
+		 * reading ST0 latches ST1 and ST2
+		 */
+		if(ccdbg_readMemory(id, REG_ST0, 3, data) < 0)
+			return -1;
+
+		*ticks = data[0] | (data[1] << 8) | (data[2] << 16);
+	}
+
+	return 0;
+}
+
+static int startTargetTimer(CCDBG_ID id, int timer, unsigned int *frequency)
+{
+	static unsigned char t1ctlValue = 0x01;		// tick frequency / 1, free-running
+	unsigned short outputData;
+	unsigned char configuration;
+	int value;
+
+	if(timer == TIMER_SLEEP)
+	{
+		*frequency = SLEEP_TIMER_FREQUENCY;
+		return 0;
+	}
+
+	/**
+	 * timer tick frequency is 32 MHz / 2^CLKCONSTA.TICKSPD, but no faster
+	 *   than the 16 MHz RC oscillator if that is the system clock
+	 */
+	if((value = ccdbg_readMemory(id, REG_CLKCONSTA, 0, 0)) < 0)
+		return -1;
+
+	*frequency = 32000000 >> ((value >> 3) & 0x7);
+
+	if((value & 0x40) && *frequency > 16000000)
+		*frequency = 16000000;
+
+	if(ccdbg_writeMemory(id, REG_T1CTL, 1, &t1ctlValue, 1) != 0)
+		return -1;
+
+	/**
+	 * keep Timer 1 from counting while the CPU is halted
+	 */
+	if(ccdbg_command(CCDBG_COMMAND_RD_CONFIG, 0, NULL, NULL, &outputData, 1) < 0)
+		return -1;
+
+	configuration = ((unsigned char *)&outputData)[0] | CCDBG_CONFIG_TIMER_SUSPENDED;
+
+	if(ccdbg_command(CCDBG_COMMAND_WR_CONFIG, 1, &configuration, NULL, NULL, 1) < 0)
+		return -1;
+
+	return 0;
+}
+
+static int timeFunctionCall(CCDBG_ID id, int timer, TimedFunction *functions, int numberOfFunctions, unsigned int *measuredCalls)
+{
+	static unsigned char t1statValue = 0xdf;	// clear OVFIF only
+	uint32_t mask = (timer == TIMER_1) ? 0xffff : 0xffffff;
+	uint32_t ticks;
+	int value;
+	int pc;
+	int i;
+
+	if((pc = ccdbg_getPc(id)) < 0)
+		return -1;
+
+	for(i = 0; i < numberOfFunctions; i++)
+	{
+		if((unsigned int)pc == functions[i].entryAddress && !functions[i].inCall)
+		{
+			if(readTargetTimer(id, timer, &ticks) != 0)
+				return -1;
+
+			if(timer == TIMER_1 && ccdbg_writeMemory(id, REG_T1STAT, 1, &t1statValue, 0) != 0)
+				return -1;
+
+			functions[i].start = ticks;
+			functions[i].inCall = 1;
+		}
+		else if((unsigned int)pc == functions[i].exitAddress && functions[i].inCall)
+		{
+			if(readTargetTimer(id, timer, &ticks) != 0)
+				return -1;
+
+			functions[i].inCall = 0;
+			++*measuredCalls;
+
+			/**
+			 * a Timer 1 overflow makes the wrapped count ambiguous
+			 */
+			if(timer == TIMER_1)
+			{
+				if((value = ccdbg_readMemory(id, REG_T1STAT, 0, 0)) < 0)
+					return -1;
+
+				if((value & 0x20))
+				{
+					++functions[i].overflows;
+					continue;
+				}
+			}
+
+			ticks = (ticks - functions[i].start) & mask;
+			++functions[i].calls;
+			functions[i].total += ticks;
+
+			if(ticks < functions[i].minimum)
+				functions[i].minimum = ticks;
+
+			if(ticks > functions[i].maximum)
+				functions[i].maximum = ticks;
+		}
+	}
+
+	/**
+	 * step past the breakpoint before resuming
+	 */
+	if(ccdbg_stepInstruction(id) < 0)
+		return -1;
+
+	return ccdbg_resume(id);
+}
+
+static void printFunctionTimes(const TimedFunction *functions, int numberOfFunctions, unsigned int frequency)
+{
+	double microseconds = 1000000.0 / frequency;
+	int i;
+
+	printf("\n   timer: %u Hz\n\n"
+			"     calls  overflows       minimum          mean       maximum  function\n"
+			"  --------------------------------------------------------------------------\n",
+			frequency);
+
+	for(i = 0; i < numberOfFunctions; i++)
+	{
+		if(functions[i].calls == 0)
+		{
+			printf("  %8u  %9u  %12s  %12s  %12s  %s\n", 0, functions[i].overflows, "-", "-", "-", functions[i].name);
+			continue;
+		}
+
+		printf("  %8u  %9u  %10.1fus  %10.1fus  %10.1fus  %s\n", functions[i].calls, functions[i].overflows,
+				functions[i].minimum * microseconds, ((double)functions[i].total / functions[i].calls) * microseconds,
+				functions[i].maximum * microseconds, functions[i].name);
+
+		printf("  %8s  %9s  %9u tk  %9.1f tk  %9u tk\n", "", "", functions[i].minimum,
+				(double)functions[i].total / functions[i].calls, functions[i].maximum);
+	}
+}
+
+typedef struct {
+	char name[64];
+	SdccVariable variable;
+	unsigned char data[WATCH_MAXIMUM_SIZE];
+} WatchedVariable;
+
+static const struct {
+	const char *name;
+	int type;
+	unsigned int size;
+} variableTypeList[] = {
+		{ "u8", SDCC_TYPE_U8, 1 },
+		{ "s8", SDCC_TYPE_S8, 1 },
+		{ "u16", SDCC_TYPE_U16, 2 },
+		{ "s16", SDCC_TYPE_S16, 2 },
+		{ "u32", SDCC_TYPE_U32, 4 },
+		{ "s32", SDCC_TYPE_S32, 4 },
+		{ "f32", SDCC_TYPE_F32, 4 }
+};
+
+static int parseWatchedVariables(char *string, int numberOfFiles, char **filenames, WatchedVariable *variables)
+{
+	SdccVariable *variable;
+	char *name;
+	int numberOfVariables = 0;
+	int numberOfTypes = sizeof(variableTypeList) / sizeof(variableTypeList[0]);
+	int i;
+
+	for(name = strtok(string, ","); name != NULL; name = strtok(NULL, ","))
+	{
+		if(numberOfVariables == WATCH_MAXIMUM_VARIABLES)
+			return -1;
+
+		variable = &variables[numberOfVariables].variable;
+		snprintf(variables[numberOfVariables].name, sizeof(variables[numberOfVariables].name), "%s", name);
+
+		if(isdigit(name[0]))
+		{
+			if((i = stringToNumber(name, &variable->address, ":")) < 1)
+				return -1;
+
+			for(name = &name[i], i = 0; i < numberOfTypes && strcmp(name, variableTypeList[i].name) != 0; i++);
+
+			if(i == numberOfTypes)
+				return -1;
+
+			variable->type = variableTypeList[i].type;
+			variable->size = variableTypeList[i].size;
+		}
+		else
+		{
+			for(i = 0; i < numberOfFiles && sdcc_findVariable(filenames[i], name, variable) != 0; i++);
+
+			if(i == numberOfFiles || variable->size < 1 || variable->size > WATCH_MAXIMUM_SIZE)
+				return -1;
+		}
+
+		++numberOfVariables;
+	}
+
+	return numberOfVariables;
+}
+
+static int compareOperationAddresses(const void *a, const void *b)
+{
+	const CCDBG_MEMORY_OPERATION *operationA = (const CCDBG_MEMORY_OPERATION *)a;
+	const CCDBG_MEMORY_OPERATION *operationB = (const CCDBG_MEMORY_OPERATION *)b;
+
+	return (operationA->address < operationB->address) ? -1 : (operationA->address > operationB->address);
+}
+
+static void printVariable(FILE *file, const WatchedVariable *variable)
+{
+	const unsigned char *data = variable->data;
+	uint32_t value = data[0];
+	float floatValue;
+	unsigned int i;
+
+	/**
+	 * SDCC keeps multi-byte values little-endian
+	 */
+	if(variable->variable.size >= 2)
+		value |= data[1] << 8;
+
+	if(variable->variable.size >= 4)
+		value |= (data[2] << 16) | ((uint32_t)data[3] << 24);
+
+	switch(variable->variable.type)
+	{
+	case SDCC_TYPE_U8:
+	case SDCC_TYPE_U16:
+	case SDCC_TYPE_U32:
+		fprintf(file, "%u", value);
+		break;
+
+	case SDCC_TYPE_S8:
+		fprintf(file, "%d", (int8_t)value);
+		break;
+
+	case SDCC_TYPE_S16:
+		fprintf(file, "%d", (int16_t)value);
+		break;
+
+	case SDCC_TYPE_S32:
+		fprintf(file, "%d", (int32_t)value);
+		break;
+
+	case SDCC_TYPE_F32:
+		memcpy(&floatValue, &value, sizeof(floatValue));
+		fprintf(file, "%g", floatValue);
+		break;
+
+	default:
+		for(i = 0; i < variable->variable.size; i++)
+			fprintf(file, "%.2x", data[i]);
+
+		break;
+	}
+}
+
+typedef struct {
+	FILE *file;
+	const WatchedVariable *variables;
+	CCDBG_MEMORY_OPERATION *operations;
+	int numberOfVariables;
+} VariableSampler;
+
+static int sampleVariables(CCDBG_ID id, void *context)
+{
+	VariableSampler *sampler = (VariableSampler *)context;
+
+	return (ccdbg_sampleMemory(id, sampler->numberOfVariables, sampler->operations) != 0) ? -1 : 0;
+}
+
+static int recordVariables(uint64_t time, int result, void *context)
+{
+	VariableSampler *sampler = (VariableSampler *)context;
+	int i;
+
+	fprintf(sampler->file, "%llu", (unsigned long long)time);
+
+	for(i = 0; i < sampler->numberOfVariables; i++)
+	{
+		fprintf(sampler->file, ",");
+		printVariable(sampler->file, &sampler->variables[i]);
+	}
+
+	fprintf(sampler->file, "\n");
+	return 0;
+}
+
+static int saveSnapshot(const char *filename, unsigned char chipId, const CCDBG_SNAPSHOT *snapshot)
+{
+	unsigned char header[SNAPSHOT_HEADER_SIZE];
+	FILE *file;
+	int okay;
+
+	if((file = fopen(filename, "wb")) == NULL)
+		return -1;
+
+	memcpy(header, SNAPSHOT_SIGNATURE, 4);
+	header[4] = chipId;
+	header[5] = 0;
+	header[6] = snapshot->sramSize & 0xff;
+	header[7] = (snapshot->sramSize >> 8) & 0xff;
+	header[8] = snapshot->pc & 0xff;
+	header[9] = (snapshot->pc >> 8) & 0xff;
+
+	okay = (fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+			fwrite(snapshot->sfr, 1, sizeof(snapshot->sfr), file) == sizeof(snapshot->sfr) &&
+			fwrite(snapshot->sram, 1, snapshot->sramSize, file) == snapshot->sramSize);
+
+	if(fclose(file) != 0)
+		okay = 0;
+
+	return okay ? 0 : -1;
+}
+
+static int loadSnapshot(const char *filename, unsigned char chipId, CCDBG_SNAPSHOT *snapshot)
+{
+	unsigned char header[SNAPSHOT_HEADER_SIZE];
+	FILE *file;
+	int okay;
+
+	if((file = fopen(filename, "rb")) == NULL)
+		return -1;
+
+	okay = (fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, SNAPSHOT_SIGNATURE, 4) == 0 && header[4] == chipId);
+
+	if(okay)
+	{
+		snapshot->sramSize = header[6] | (header[7] << 8);
+		snapshot->pc = header[8] | (header[9] << 8);
+
+		okay = (snapshot->sramSize <= CCDBG_MAXIMUM_SRAM_SIZE &&
+				fread(snapshot->sfr, 1, sizeof(snapshot->sfr), file) == sizeof(snapshot->sfr) &&
+				fread(snapshot->sram, 1, snapshot->sramSize, file) == snapshot->sramSize);
+	}
+
+	fclose(file);
+
+	return okay ? 0 : -1;
+}
+
+static int parseCodeAddress(const char *string, const SdccSymbols *symbols, unsigned int *address)
+{
+	const SdccSymbol *symbol;
+
+	if(isdigit(string[0]))
+		return stringToNumber(string, address, "");
+
+	if((symbol = sdcc_findSymbolByName(symbols, string)) == NULL)
+		return -1;
+
+	*address = symbol->address;
+	return 0;
+}
+
+static int runToAddress(CCDBG_ID id, unsigned int address)
+{
+	int result;
+
+	if(ccdbg_setBreakpoint(id, 0, address, 1) != 0 || ccdbg_resume(id) != 0)
+		return -1;
+
+	result = ccdbg_waitForHalt(id, RUN_TIMEOUT, NULL);
+
+	if(ccdbg_setBreakpoint(id, 0, 0, 0) != 0)
+		return -1;
+
+	return (result > 0) ? 0 : -1;
+}
+
+static int paintStack(CCDBG_ID id, unsigned int *address, unsigned int *size)
+{
+	unsigned char *pattern;
+	unsigned int liveEnd;
+	int value;
+	int result;
+
+	/**
+	 * leave the live part of an IDATA stack alone
+	 */
+	if(*address + *size > IDATA_WINDOW_START && *address < IDATA_WINDOW_START + 0x100)
+	{
+		if((value = ccdbg_readMemory(id, REG_SP, 0, 0)) < 0)
+			return -1;
+
+		if((liveEnd = IDATA_WINDOW_START + value + 1) > *address)
+		{
+			if(liveEnd >= *address + *size)
+				return -1;
+
+			*size -= liveEnd - *address;
+			*address = liveEnd;
+		}
+	}
+
+	if((pattern = (unsigned char *)malloc(*size)) == NULL)
+		return -1;
+
+	memset(pattern, STACK_PAINT_PATTERN, *size);
+	result = ccdbg_burstWriteMemory(id, *address, *size, pattern, 0);
+	free(pattern);
+
+	return result;
+}
+
+static int findStackHighWaterMark(CCDBG_ID id, unsigned int address, unsigned int size, unsigned int *mark, unsigned int *reads, unsigned int *bytesRead)
+{
+	unsigned char data[STACK_LINEAR_SCAN_SIZE];
+	unsigned int low = address;
+	unsigned int high = address + size;
+	unsigned int middle;
+	unsigned int i;
+
+	*reads = 0;
+	*bytesRead = 0;
+
+	/**
+	 * everything from high up is still painted and the byte below low, if
+	 *   any, is not; a probe that is all paint moves high down to it, one
+	 *   that is not moves low past its last changed byte
+	 */
+	while(high - low > STACK_LINEAR_SCAN_SIZE)
+	{
+		middle = low + (high - low - STACK_PROBE_SIZE) / 2;
+
+		if(ccdbg_readMemory(id, middle, STACK_PROBE_SIZE, data) < 0)
+			return -1;
+
+		++*reads;
+		*bytesRead += STACK_PROBE_SIZE;
+
+		for(i = STACK_PROBE_SIZE; i > 0 && data[i - 1] == STACK_PAINT_PATTERN; i--);
+
+		if(i == 0)
+			high = middle;
+		else
+			low = middle + i;
+	}
+
+	if(high > low)
+	{
+		if(ccdbg_readMemory(id, low, high - low, data) < 0)
+			return -1;
+
+		++*reads;
+		*bytesRead += high - low;
+
+		for(i = high - low; i > 0 && data[i - 1] == STACK_PAINT_PATTERN; i--);
+
+		low += i;
+	}
+
+	*mark = low;
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int okay = 0;
+	unsigned char *buffer = NULL;
+	const unsigned char *data = NULL;
+	FILE *file = NULL;
+	IntelHexMemory *intelHexMemory = NULL;
+	IntelHex intelHex;
+	SdccSymbols symbols;
+	CCDBG_INFO info;
+	unsigned int address;
+	unsigned int size;
+	unsigned int page;
+	unsigned int count;
+	unsigned int startAddress;
+	unsigned int endAddress;
+	TimedFunction timedFunctions[TIMING_MAXIMUM_FUNCTIONS];
+	int numberOfTimedFunctions;
+	unsigned int frequency;
+	int timer;
+	unsigned int *histogram = NULL;
+	unsigned short *pcs = NULL;
+	unsigned int samples;
+	unsigned int logBytes;
+	WatchedVariable watchedVariables[WATCH_MAXIMUM_VARIABLES];
+	CCDBG_MEMORY_OPERATION operations[WATCH_MAXIMUM_VARIABLES];
+	int numberOfWatchedVariables;
+	CCDBG_SNAPSHOT *snapshot = NULL;
+	IntelHexDigest *digests = NULL;
+	IntelHexDigest imageDigest;
+	GdbServerStatistics gdbServerStatistics;
+	const char *extension;
+	unsigned int reads;
+	unsigned int bytesRead;
+	SamplingStatistics samplingStatistics;
+	VariableSampler variableSampler;
+	LogDrain logDrain;
+	uint64_t startTime;
+	uint64_t haltTime;
+	uint64_t maximumHaltTime;
+	uint64_t now;
+	int fileFormat;
+	int verify;
+	int command;
+	int debugCommand;
+	int result;
+	int i;
+
+	if(argc < 2 || *argv[1] != '-' || strlen(argv[1]) != 3)
+		command = UNKNOWN_COMMAND;
+	else
+		for(command = COMMAND_ITEMS; --command > UNKNOWN_COMMAND && memcmp(argv[1], commandList[command], 3) != 0; );
+
+	if(command == UNKNOWN_COMMAND)
+	{
+		printf("\n"
+				"  %s <command> [args]\n"
+				"    " EXECUTE_DEBUG_COMMAND ", execute debug command\n"
+				"    " SHOW_CHIP_INFORMATION ", show chip information\n"
+				"    " EXECUTE_INSTRUCTION ", execute instruction\n"
+				"    " READ_MEMORY ", read memory\n"
+				"    " WRITE_MEMORY ", write memory\n"
+				"    " READ_FLASH_PAGE ", read flash page\n"
+				"    " WRITE_FLASH_PAGE ", write flash page\n"
+				"    " ERASE_FLASH_PAGE ", erase flash page\n"
+				"    " CHECK_FLASH_PAGE ", check if flash page is locked\n"
+				"    " LOCK_FLASH_PAGES ", lock flash pages\n"
+				"    " UNLOCK_FLASH_PAGES ", unlock flash pages\n"
+				"    " READ_FLASH ", read flash\n"
+				"    " WRITE_FLASH ", write flash\n"
+				"    " ERASE_FLASH ", erase flash\n"
+				"    " LOCK_DEBUG_INTERFACE ", lock debug interface\n"
+				"    " RUN_FROM_SRAM ", load and run from SRAM\n"
+				"    " PROFILE ", profile firmware by sampling the program counter\n"
+				"    " TRACE ", trace instructions by stepping the CPU\n"
+				"    " TIME_FUNCTIONS ", time functions with hardware breakpoints\n"
+				"    " DRAIN_LOG ", stream the firmware's log channel\n"
+				"    " SAMPLE_VARIABLES ", sample variables to a CSV file\n"
+				"    " STACK_USAGE ", measure peak stack usage\n"
+				"    " TAKE_SNAPSHOT ", save a snapshot of the CPU state\n"
+				"    " RESTORE_SNAPSHOT ", restore a snapshot of the CPU state\n"
+				"    " GDB_SERVER ", serve a GDB remote connection\n"
+				"    " WAIT_FOR_HALT ", run to a breakpoint\n"
+				"    " DIGEST ", compare a file with flash by page digests\n"
+				"\n",
+				argv[0]);
+
+		return -1;
+	}
+
+	intelHex_initializeHexInfo(&intelHex, 0);
+	sdcc_initializeSymbols(&symbols);
+
+	printf("\n");
+
+	do
+	{
+		if(ccdbgDevice_initialize() != 0)
+		{
+			printf("FAILED to initialize the ccdbg device\n");
+			break;
+		}
+
+		if(ccdbg_identifyChip(&info) == CCDBG_INVALID_ID)
+		{
+			printf("FAILED to identify the chip\n");
+			break;
+		}
+
+		if(info.isLocked)
+		{
+			if(command != COMMAND_SHOW_CHIP_INFORMATION && command != COMMAND_ERASE_FLASH)
+			{
+				printf("FAILED: chip is LOCKED -- only \"" SHOW_CHIP_INFORMATION "\" and \"" ERASE_FLASH "\" commands are available\n");
+				break;
+			}
+		}
+
+		switch(command)
+		{
+		case COMMAND_EXECUTE_DEBUG_COMMAND:
+
+			if(argc < 3 || argc > 4 || strlen(argv[2]) != 2)
+				break;
+
+			for(debugCommand = DEBUG_COMMAND_ITEMS; --debugCommand > UNKNOWN_DEBUG_COMMAND && memcmp(argv[2], debugCommandList[debugCommand].string, 2) != 0; );
+
+			if(debugCommand == UNKNOWN_DEBUG_COMMAND)
+				break;
+
+			if(debugCommandList[debugCommand].minimumInputBytes > 0)
+			{
+				if(argc != 4)
+					break;
+
+				if((int)(size = hexStringToBytes(&buffer, argv[3])) < 1)
+					break;
+
+				if(size < debugCommandList[debugCommand].minimumInputBytes || size > debugCommandList[debugCommand].maximumInputBytes)
+					break;
+			}
+			else
+			{
+				if(argc != 3)
+					break;
+
+				size = 0;
+			}
+
+			printf("executing debug command...\n");
+
+			result = ccdbg_command(debugCommandList[debugCommand].id, size, buffer, &size, NULL, 1);
+			okay = (result >= 0);
+
+			printf("\n>> ");
+
+			if(okay)
+			{
+				printf("debug command output is %.2x", ((unsigned char *)&result)[0]);
+
+				if(size > 1)
+					printf(" %.2x", ((unsigned char *)&result)[1]);
+
+				printf("\n");
+			}
+			else
+				printf("FAILED\n");
+
+			goto done;
+
+		case COMMAND_SHOW_CHIP_INFORMATION:
+
+			if(argc != 2)
+				break;
+
+			printf("  chip info:\n"
+					"    id: 0x%.2x\n"
+					"    revision: 0x%.2x\n"
+					"    flash size: %u bytes (%.1fKB)\n"
+					"    writable flash size: %u bytes (%.1fKB)\n"
+					"    flash bank size: %u bytes (%.1fKB)\n"
+					"    flash page size: %u bytes (%.1fKB)\n"
+					"    number of flash pages: %u\n"
+					"    SRAM size: %u bytes (%.1fKB)\n"
+					"    locked: %s\n"
+					"    IEEE address: ",
+					info.id,
+					info.rev,
+					info.flashSize, KB(info.flashSize),
+					info.writableFlashSize, KB(info.writableFlashSize),
+					info.flashBankSize, KB(info.flashBankSize),
+					info.flashPageSize, KB(info.flashPageSize),
+					info.numberOfFlashPages,
+					info.sramSize, KB(info.sramSize),
+					info.isLocked ? "yes" : "no");
+
+			if(info.ieeeAddressLength == 0)
+				printf("n/a\n");
+			else
+			{
+				int i;
+
+				for(i = (int)info.ieeeAddressLength; i-- > 0; )
+					printf("%.2x", info.ieeeAddress[i]);
+
+				printf("\n");
+			}
+
+			okay = 1;
+			goto done;
+
+		case COMMAND_EXECUTE_INSTRUCTION:
+
+			if(argc != 3)
+				break;
+
+			if((int)(size = hexStringToBytes(&buffer, argv[2])) < 1)
+				break;
+
+			printf("executing instruction...\n"
+					"  code: %s\n", argv[2]);
+
+			result = ccdbg_executeInstruction(&info, size, buffer);
+			okay = (result >= 0);
+
+			printf("\n>> ");
+
+			if(okay)
+				printf("resulting accumulator register value is 0x%.2x\n", result);
+			else
+				printf("FAILED\n");
+
+			goto done;
+
+		case COMMAND_ERASE_FLASH_PAGE:
+
+			if(argc != 3)
+				break;
+
+			if(stringToNumber(argv[2], &page, "") != 0)
+				break;
+
+			printf("erasing flash page %d...\n", page);
+
+			result = ccdbg_eraseFlashPage(&info, page);
+			okay = (result == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_CHECK_FLASH_PAGE:
+
+			if(argc != 3)
+				break;
+
+			if(stringToNumber(argv[2], &page, "") != 0)
+				break;
+
+			printf("checking if flash page is locked...\n"
+					"  page: %d\n",
+					page);
+
+			result = ccdbg_isFlashPageLocked(&info, page);
+			okay = (result >= 0);
+
+			printf("\n>> ");
+
+			if(okay)
+				printf("flash page is %s\n", (result == 0) ? "NOT LOCKED" : "LOCKED");
+			else
+				printf("FAILED\n");
+
+			goto done;
+
+		case COMMAND_LOCK_FLASH_PAGES:
+		case COMMAND_UNLOCK_FLASH_PAGES:
+
+			if(argc < 3 || argc > 4)
+				break;
+
+			if(stringToNumber(argv[2], &page, "") != 0)
+				break;
+
+			if(argc == 4)
+			{
+				if(stringToNumber(argv[3], &count, "") != 0 || count < 1)
+					break;
+			}
+			else
+				count = 1;
+
+			printf("%slocking flash pages...\n"
+					"  start page: %u\n"
+					"  items: %u\n",
+					(command == COMMAND_LOCK_FLASH_PAGES) ? "" : "un", page, count);
+
+			if(command == COMMAND_LOCK_FLASH_PAGES)
+				result = ccdbg_lockFlashPages(&info, page, count);
+			else
+				result = ccdbg_unlockFlashPages(&info, page, count);
+
+			okay = (result == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_ERASE_FLASH:
+
+			if(argc != 2)
+				break;
+
+			printf("erasing flash...\n");
+
+			result = ccdbg_eraseFlash(&info);
+			okay = (result == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_LOCK_DEBUG_INTERFACE:
+
+			if(argc != 2)
+				break;
+
+			printf("locking debug interface...\n");
+
+			result = ccdbg_lock(&info);
+			okay = (result == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_READ_MEMORY:
+		case COMMAND_READ_FLASH:
+
+			if(parseReadArgs(argc, argv, &address, &size, NULL, &fileFormat, &intelHex, &file, &buffer) != 0)
+				break;
+
+			printf("reading %s...\n"
+					"  address: 0x%.8x\n"
+					"  size: %u\n",
+					(command == COMMAND_READ_MEMORY) ? "memory" : "flash", address, size);
+
+			if(command == COMMAND_READ_MEMORY)
+				result = ccdbg_readMemory(&info, address, size, buffer);
+			else
+				result = ccdbg_readFlash(&info, address, size, buffer);
+
+			okay = (result > 0);
+
+			printf("\n>> ");
+
+			if(okay)
+				saveReadData(argc, argv, address, result, fileFormat, &intelHex, file, buffer);
+			else
+				printf("FAILED\n");
+
+			goto done;
+
+		case COMMAND_READ_FLASH_PAGE:
+
+			size = info.flashPageSize;
+
+			if(parseReadArgs(argc, argv, &address, &size, &page, &fileFormat, &intelHex, &file, &buffer) != 0)
+				break;
+
+			printf("reading flash page...\n"
+					"  page: %d\n"
+					"  address: 0x%.8x\n"
+					"  size: %u\n",
+					page, address, size);
+
+			result = ccdbg_readFlashPage(&info, page, buffer);
+			okay = (result == 0);
+
+			printf("\n>> ");
+
+			if(okay)
+				saveReadData(argc, argv, address, size, fileFormat, &intelHex, file, buffer);
+			else
+				printf("FAILED\n");
+
+			goto done;
+
+		case COMMAND_WRITE_MEMORY:
+		case COMMAND_WRITE_FLASH:
+
+			if(command == COMMAND_WRITE_FLASH && argc > 2 && strcmp(argv[2], "img") == 0)
+			{
+				if(argc != 4 && (argc != 5 || strcmp(argv[4], "verify") != 0))
+					break;
+
+				verify = (argc == 5);
+
+				printf("writing flash...\n"
+						"  file: %s\n"
+						"  verify: %d\n",
+						argv[3], verify);
+
+				okay = (writeFlashFromImageFile(&info, argv[3], verify, &page, &count, &size) == 0);
+
+				printf("\n>> ");
+
+				if(okay)
+					printf("%u pages written, %u erased, %u unchanged\n", page, count, size);
+				else
+					printf("FAILED\n");
+
+				goto done;
+			}
+
+			if(command == COMMAND_WRITE_FLASH && strcmp(argv[2], "hex") == 0 &&
+					(argc == 4 || (argc == 5 && strcmp(argv[4], "verify") == 0)))
+			{
+				verify = (argc == 5);
+
+				printf("writing flash...\n"
+						"  file: %s\n"
+						"  verify: %d\n",
+						argv[3], verify);
+
+				result = writeFlashFromHexFile(&info, argv[3], verify, &i);
+
+				if(i)
+				{
+					okay = (result > 0);
+
+					printf("\n>> ");
+
+					if(okay)
+						printf("%d bytes written\n", result);
+					else
+						printf("FAILED\n");
+
+					goto done;
+				}
+
+				printf("\n  records are out of order or past the writable flash, loading the whole file\n\n");
+			}
+
+			if(parseWriteArgs(argc, argv, &address, &size, NULL, &verify, &intelHex, &buffer, &data, &intelHexMemory) != 0)
+				break;
+
+			while(1)
+			{
+				printf("writing %s...\n"
+						"  address: 0x%.8x\n"
+						"  size: %u\n"
+						"  verify: %d\n",
+						(command == COMMAND_WRITE_MEMORY) ? "memory" : "flash",
+						address, size, verify);
+
+				if(command == COMMAND_WRITE_MEMORY)
+					result = (ccdbg_burstWriteMemory(&info, address, size, data, verify) == 0) ? (int)size : -1;
+				else
+					result = ccdbg_writeFlash(&info, address, size, data, verify);
+
+				okay = (result > 0);
+
+				printf("\n>> ");
+
+				if(okay)
+					printf("%d bytes written\n", result);
+				else
+				{
+					printf("FAILED\n");
+					break;
+				}
+
+				if(intelHexMemory == NULL)
+					break;
+
+				printf("\n");
+
+				address = intelHexMemory->baseAddress;
+				size = intelHexMemory->size;
+				data = intelHexMemory->data;
+				intelHexMemory = intelHexMemory->next;
+			}
+
+			goto done;
+
+		case COMMAND_WRITE_FLASH_PAGE:
+
+			size = info.flashPageSize;
+
+			if(parseWriteArgs(argc, argv, &address, &size, &page, &verify, &intelHex, &buffer, &data, NULL) != 0)
+				break;
+
+			printf("writing flash page...\n"
+					"  page: %d\n"
+					"  address: 0x%.8x\n"
+					"  size: %u\n"
+					"  verify: %d\n",
+					page, address, size, verify);
+
+			result = ccdbg_writeFlashPage(&info, page, data, verify);
+			okay = (result == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_RUN_FROM_SRAM:
+
+			if((verify = (strcmp(argv[argc - 1], "verify") == 0)))
+				--argc;
+
+			if(argc < 4 || argc > 5)
+				break;
+
+			if(strcmp(argv[2], "hex") == 0)
+				fileFormat = INTEL_HEX_FORMAT_HEX;
+			else if(strcmp(argv[2], "bin") == 0)
+				fileFormat = INTEL_HEX_FORMAT_BIN;
+			else
+				break;
+
+			if(intelHex_convert(fileFormat, argv[3], NULL, 0, NULL, &intelHex, INTEL_HEX_IGNORE_UNKNOWN_RECORD) != 0 || intelHex.memory == NULL)
+				break;
+
+			if(argc == 5)
+			{
+				if(stringToNumber(argv[4], &address, "") != 0)
+					break;
+			}
+			else if(intelHex.eip != INTEL_HEX_INVALID_ADDRESS)
+				address = intelHex.eip;
+			else if(intelHex.cs != INTEL_HEX_INVALID_ADDRESS)
+				address = (intelHex.cs << 4) + intelHex.ip;
+			else
+			{
+				address = intelHex.memory->baseAddress;
+
+				for(intelHexMemory = intelHex.memory->next; intelHexMemory != NULL; intelHexMemory = intelHexMemory->next)
+				{
+					if(intelHexMemory->baseAddress < address)
+						address = intelHexMemory->baseAddress;
+				}
+			}
+
+			startAddress = CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - info.sramSize;
+			endAddress = CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - CCDBG_SRAM_IDATA_SIZE;
+
+			printf("running from SRAM...\n"
+					"  file: %s\n"
+					"  entry address: 0x%.8x\n"
+					"  verify: %d\n",
+					argv[3], address, verify);
+
+			/**
+			 * check that the whole image fits in the SRAM window before loading
+			 */
+			for(intelHexMemory = intelHex.memory; intelHexMemory != NULL; intelHexMemory = intelHexMemory->next)
+			{
+				if(intelHexMemory->size == 0 || intelHexMemory->baseAddress < startAddress ||
+						intelHexMemory->size > (endAddress - intelHexMemory->baseAddress))
+					break;
+			}
+
+			if(intelHexMemory != NULL)
+			{
+				printf("\n>> FAILED: %u bytes at 0x%.8x do not fit in SRAM (0x%.4x ~ 0x%.4x)\n",
+						intelHexMemory->size, intelHexMemory->baseAddress, startAddress, endAddress - 1);
+
+				goto done;
+			}
+
+			if(address < startAddress || address >= endAddress)
+			{
+				printf("\n>> FAILED: entry address is not in SRAM (0x%.4x ~ 0x%.4x)\n", startAddress, endAddress - 1);
+				goto done;
+			}
+
+			for(intelHexMemory = intelHex.memory; intelHexMemory != NULL; intelHexMemory = intelHexMemory->next)
+			{
+				size = intelHexMemory->size;
+
+				printf("\n  loading %u bytes at 0x%.8x\n", size, intelHexMemory->baseAddress);
+
+				if(ccdbg_burstWriteMemory(&info, intelHexMemory->baseAddress - CCDBG_SRAM_CODE_OFFSET, size, intelHexMemory->data, verify) != 0)
+					break;
+			}
+
+			okay = (intelHexMemory == NULL && ccdbg_runFromSram(&info, address) == 0);
+
+			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+
+			goto done;
+
+		case COMMAND_PROFILE:
+
+			if(argc < 4)
+				break;
+
+			if(stringToNumber(argv[2], &count, "") != 0 || count < 1 || count > 1000000)
+				break;
+
+			if(stringToNumber(argv[3], &size, "") != 0 || size < 1)
+				break;
+
+			for(i = 4; i < argc; i++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[i]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[i]);
+					goto done;
+				}
+			}
+
+			if((histogram = (unsigned int *)calloc(PROFILE_HISTOGRAM_SIZE, sizeof(unsigned int))) == NULL)
+				break;
+
+			printf("profiling...\n"
+					"  rate: %u samples per second\n"
+					"  duration: %u seconds\n"
+					"  symbols: %u\n",
+					count, size, symbols.numberOfSymbols);
+
+			if(startCpu(&info) != 0)
+				goto done;
+
+			okay = (sampleAtInterval(&info, 1000000 / count, size, samplePc, recordPc, histogram, &samplingStatistics) == 0);
+			samples = samplingStatistics.samples;
+			haltTime = samplingStatistics.haltTime;
+			now = samplingStatistics.duration;
+
+			printf("\n>> ");
+
+			if(!okay)
+				printf("FAILED after ");
+
+			printf("%u samples in %.2f seconds (%.1f per second)\n"
+					"   mean halt window: %.1f us (HALT, GET_PC, and RESUME), CPU halted %.2f%% of the time\n",
+					samples, now / 1000000.0, (now > 0) ? ((samples * 1000000.0) / now) : 0.0,
+					(samples > 0) ? ((double)haltTime / samples) : 0.0, (now > 0) ? ((100.0 * haltTime) / now) : 0.0);
+
+			if(samples > 0 && printProfile(histogram, samples, &symbols) != 0)
+				okay = 0;
+
+			goto done;
+
+		case COMMAND_TRACE:
+
+			if(argc < 4)
+				break;
+
+			if(stringToNumber(argv[2], &count, "") != 0 || count < 1 || count > TRACE_MAXIMUM_INSTRUCTIONS)
+				break;
+
+			address = 0;
+			size = PROFILE_HISTOGRAM_SIZE;
+			i = 4;
+
+			if(argc > 4 && (result = stringToNumber(argv[4], &address, ":")) > 0)
+			{
+				if(stringToNumber(&argv[4][result], &size, "") != 0 || size < 1)
+					break;
+
+				++i;
+			}
+
+			for(; i < argc; i++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[i]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[i]);
+					goto done;
+				}
+			}
+
+			if((pcs = (unsigned short *)malloc(count * sizeof(unsigned short))) == NULL)
+				break;
+
+			printf("tracing...\n"
+					"  instructions: %u\n"
+					"  address: 0x%.8x\n"
+					"  size: %u\n"
+					"  symbols: %u\n",
+					count, address, size, symbols.numberOfSymbols);
+
+			/**
+			 * stepping from a program counter outside the range would stop at
+			 *   once, so run to its start with a hardware breakpoint first
+			 */
+			if((result = ccdbg_getPc(&info)) < 0 ||
+					(((unsigned int)result < address || (unsigned int)result >= address + size) && runToAddress(&info, address) != 0))
+			{
+				printf("\n>> FAILED to reach the start address\n");
+				goto done;
+			}
+
+			startTime = ccdbgDevice_getMicroseconds();
+			result = ccdbg_traceInstructions(&info, count, address, address + size, pcs);
+			now = ccdbgDevice_getMicroseconds() - startTime;
+
+			okay = (result >= 0);
+			count = okay ? (unsigned int)result : ~(unsigned int)result;
+
+			printf("\n>> ");
+
+			if(!okay)
+				printf("FAILED after ");
+
+			printf("%u instructions in %.2f seconds (%.1f per second)\n", count, now / 1000000.0, (now > 0) ? ((count * 1000000.0) / now) : 0.0);
+
+			if(count > 0)
+			{
+				if(saveTrace(argv[3], pcs, count) != 0)
+				{
+					printf("   FAILED to save trace to \"%s\"\n", argv[3]);
+					okay = 0;
+				}
+				else
+					printf("   saved trace to \"%s\"\n", argv[3]);
+
+				if(printTraceSummary(pcs, count, &symbols) != 0)
+					okay = 0;
+			}
+
+			goto done;
+
+		case COMMAND_TIME_FUNCTIONS:
+
+			if(argc < 5)
+				break;
+
+			if(stringToNumber(argv[2], &count, "") != 0 || count < 1)
+				break;
+
+			if(strcmp(argv[3], "t1") == 0)
+				timer = TIMER_1;
+			else if(strcmp(argv[3], "st") == 0)
+				timer = TIMER_SLEEP;
+			else
+				break;
+
+			for(i = 5; i < argc; i++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[i]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[i]);
+					goto done;
+				}
+			}
+
+			if((numberOfTimedFunctions = parseTimedFunctions(argv[4], &symbols, timedFunctions)) < 1)
+				break;
+
+			printf("timing functions...\n"
+					"  calls: %u\n"
+					"  timer: %s\n",
+					count, argv[3]);
+
+			for(i = 0; i < numberOfTimedFunctions; i++)
+			{
+				printf("  %s: entry 0x%.4x, exit 0x%.4x\n", timedFunctions[i].name,
+						timedFunctions[i].entryAddress, timedFunctions[i].exitAddress);
+			}
+
+			if(startTargetTimer(&info, timer, &frequency) != 0)
+			{
+				printf("\n>> FAILED to start the timer\n");
+				goto done;
+			}
+
+			/**
+			 * two breakpoints per function, at its entry and at its return
+			 */
+			for(i = 0; i < numberOfTimedFunctions * 2; i++)
+			{
+				if(ccdbg_setBreakpoint(&info, i, (i & 0x1) ? timedFunctions[i / 2].exitAddress : timedFunctions[i / 2].entryAddress, 1) != 0)
+					break;
+			}
+
+			okay = (i == numberOfTimedFunctions * 2 && ccdbg_resume(&info) == 0);
+			samples = 0;
+
+			while(okay && samples < count)
 			{
-				if(stringToNumber(argv[3], &count, "") != 0 || count < 1)
+				if((result = ccdbg_waitForHalt(&info, TIMING_TIMEOUT, NULL)) < 0)
+					okay = 0;
+				else if(result == 0)
+				{
+					printf("\n   no breakpoint hit in %u seconds\n", TIMING_TIMEOUT / 1000000);
 					break;
+				}
+				else
+					okay = (timeFunctionCall(&info, timer, timedFunctions, numberOfTimedFunctions, &samples) == 0);
 			}
-			else
-				count = 1;
 
-			printf("%slocking flash pages...\n"
-					"  start page: %u\n"
-					"  items: %u\n",
-					(command == COMMAND_LOCK_FLASH_PAGES) ? "" : "un", page, count);
+			/**
+			 * leave the firmware running without breakpoints
+			 */
+			for(i = 0; i < numberOfTimedFunctions * 2; i++)
+				ccdbg_setBreakpoint(&info, i, 0, 0);
 
-			if(command == COMMAND_LOCK_FLASH_PAGES)
-				result = ccdbg_lockFlashPages(&info, page, count);
-			else
-				result = ccdbg_unlockFlashPages(&info, page, count);
+			printf("\n>> %s%u calls\n", okay ? "" : "FAILED after ", samples);
 
-			okay = (result == 0);
+			printFunctionTimes(timedFunctions, numberOfTimedFunctions, frequency);
 
-			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+			goto done;
+
+		case COMMAND_DRAIN_LOG:
+
+			if(argc < 5 || argc > 6)
+				break;
+
+			if(stringToNumber(argv[2], &address, "") != 0)
+				break;
+
+			if(stringToNumber(argv[3], &count, "") != 0 || count < 1 || count > 0xffffffff / 1000)
+				break;
+
+			if(stringToNumber(argv[4], &size, "") != 0 || size < 1)
+				break;
+
+			if(argc == 6 && (file = fopen(argv[5], "ab")) == NULL)
+			{
+				printf("FAILED to open \"%s\" file for writing\n", argv[5]);
+				goto done;
+			}
+
+			if((buffer = (unsigned char *)malloc(LOG_MAXIMUM_DRAIN_SIZE)) == NULL)
+				break;
+
+			printf("draining log...\n"
+					"  address: 0x%.4x\n"
+					"  interval: %u ms\n"
+					"  duration: %u seconds\n"
+					"  output: %s\n\n",
+					address, count, size, (file != NULL) ? argv[5] : "stdout");
+
+			fflush(stdout);
+
+			if(startCpu(&info) != 0)
+				goto done;
+
+			logDrain.address = address;
+			logDrain.buffer = buffer;
+			logDrain.file = (file != NULL) ? file : stdout;
+			logDrain.bytes = 0;
+
+			okay = (sampleAtInterval(&info, count * 1000, size, drainLog, recordLog, &logDrain, &samplingStatistics) == 0);
+			logBytes = logDrain.bytes;
+			samples = samplingStatistics.samples;
+			haltTime = samplingStatistics.haltTime;
+			maximumHaltTime = samplingStatistics.maximumHaltTime;
+			now = samplingStatistics.duration;
+
+			printf("\n\n>> ");
+
+			if(!okay)
+				printf("FAILED after ");
+
+			printf("%u bytes in %u drains in %.2f seconds\n"
+					"   halt window: %.1f us mean, %llu us maximum, CPU halted %.2f%% of the time\n",
+					logBytes, samples, now / 1000000.0, (samples > 0) ? ((double)haltTime / samples) : 0.0,
+					(unsigned long long)maximumHaltTime, (now > 0) ? ((100.0 * haltTime) / now) : 0.0);
 
 			goto done;
 
-		case COMMAND_ERASE_FLASH:
+		case COMMAND_SAMPLE_VARIABLES:
 
-			if(argc != 2)
+			if(argc < 6)
 				break;
 
-			printf("erasing flash...\n");
+			if(stringToNumber(argv[2], &count, "") != 0 || count < 1 || count > 1000000)
+				break;
 
-			result = ccdbg_eraseFlash(&info);
-			okay = (result == 0);
+			if(stringToNumber(argv[3], &size, "") != 0 || size < 1)
+				break;
 
-			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+			if((numberOfWatchedVariables = parseWatchedVariables(argv[5], argc - 6, &argv[6], watchedVariables)) < 1)
+				break;
+
+			if((file = fopen(argv[4], "w")) == NULL)
+			{
+				printf("FAILED to open \"%s\" file for writing\n", argv[4]);
+				goto done;
+			}
+
+			printf("sampling variables...\n"
+					"  rate: %u samples per second\n"
+					"  duration: %u seconds\n"
+					"  output: %s\n",
+					count, size, argv[4]);
+
+			fprintf(file, "time_us");
+
+			for(i = 0; i < numberOfWatchedVariables; i++)
+			{
+				printf("  %s: 0x%.4x, %u bytes\n", watchedVariables[i].name, watchedVariables[i].variable.address, watchedVariables[i].variable.size);
+				fprintf(file, ",%s", watchedVariables[i].name);
+
+				operations[i].type = CCDBG_MEMORY_READ;
+				operations[i].address = watchedVariables[i].variable.address;
+				operations[i].size = watchedVariables[i].variable.size;
+				operations[i].data = watchedVariables[i].data;
+				operations[i].sourceAddress = 0;
+			}
+
+			fprintf(file, "\n");
+
+			/**
+			 * in address order, one variable usually follows another with
+			 *   nothing more than INC DPTR
+			 */
+			qsort(operations, numberOfWatchedVariables, sizeof(CCDBG_MEMORY_OPERATION), compareOperationAddresses);
+
+			if(startCpu(&info) != 0)
+				goto done;
+
+			variableSampler.file = file;
+			variableSampler.variables = watchedVariables;
+			variableSampler.operations = operations;
+			variableSampler.numberOfVariables = numberOfWatchedVariables;
+
+			okay = (sampleAtInterval(&info, 1000000 / count, size, sampleVariables, recordVariables, &variableSampler, &samplingStatistics) == 0);
+			samples = samplingStatistics.samples;
+			haltTime = samplingStatistics.haltTime;
+			maximumHaltTime = samplingStatistics.maximumHaltTime;
+			now = samplingStatistics.duration;
+
+			printf("\n>> ");
+
+			if(!okay)
+				printf("FAILED after ");
+
+			printf("%u samples in %.2f seconds (%.1f per second)\n"
+					"   halt window: %.1f us mean, %llu us maximum, CPU halted %.2f%% of the time\n",
+					samples, now / 1000000.0, (now > 0) ? ((samples * 1000000.0) / now) : 0.0,
+					(samples > 0) ? ((double)haltTime / samples) : 0.0, (unsigned long long)maximumHaltTime,
+					(now > 0) ? ((100.0 * haltTime) / now) : 0.0);
 
 			goto done;
 
-		case COMMAND_LOCK_DEBUG_INTERFACE:
+		case COMMAND_STACK_USAGE:
 
-			if(argc != 2)
+			if(argc < 4)
 				break;
 
-			printf("locking debug interface...\n");
+			if((result = stringToNumber(argv[2], &address, ":")) < 1 || stringToNumber(&argv[2][result], &size, "") != 0 || size < 1)
+				break;
 
-			result = ccdbg_lock(&info);
-			okay = (result == 0);
+			if(stringToNumber(argv[3], &count, "") != 0 || count < 1)
+				break;
 
-			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+			i = 4;
+			startAddress = (unsigned int)-1;
+
+			/**
+			 * anything but a symbol file is the paint address
+			 */
+			if(argc > 4 && ((extension = strrchr(argv[4], '.')) == NULL || strlen(extension) != 4))
+				++i;
+
+			for(result = i; result < argc; result++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[result]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[result]);
+					goto done;
+				}
+			}
+
+			if(i == 5 && parseCodeAddress(argv[4], &symbols, &startAddress) != 0)
+				break;
+
+			printf("measuring stack usage...\n"
+					"  stack: 0x%.4x ~ 0x%.4x\n"
+					"  duration: %u seconds\n",
+					address, address + size - 1, count);
+
+			if(startAddress != (unsigned int)-1)
+			{
+				printf("  paint address: 0x%.4x\n", startAddress);
+
+				if(runToAddress(&info, startAddress) != 0)
+				{
+					printf("\n>> FAILED to reach the paint address\n");
+					goto done;
+				}
+			}
+
+			if(paintStack(&info, &address, &size) != 0)
+			{
+				printf("\n>> FAILED to paint the stack\n");
+				goto done;
+			}
+
+			printf("  painted: 0x%.4x ~ 0x%.4x\n", address, address + size - 1);
+
+			if(ccdbg_resume(&info) != 0)
+			{
+				printf("\n>> FAILED to start the CPU\n");
+				goto done;
+			}
+
+			sleep(count);
+
+			okay = (ccdbg_halt(&info) == 0 && findStackHighWaterMark(&info, address, size, &endAddress, &reads, &bytesRead) == 0);
+
+			if(ccdbg_resume(&info) != 0)
+				okay = 0;
+
+			if(!okay)
+			{
+				printf("\n>> FAILED to scan the stack\n");
+				goto done;
+			}
+
+			printf("\n>> peak usage: %u of %u bytes (%.1f%%)", endAddress - address, size, (100.0 * (endAddress - address)) / size);
+
+			if(endAddress > address)
+				printf(", up to 0x%.4x", endAddress - 1);
+
+			printf("\n   scan: %u reads, %u of %u bytes\n", reads, bytesRead, size);
+
+			if(endAddress == address + size)
+				printf("   WARNING: no paint left at the top; the stack may have overflowed\n");
 
 			goto done;
 
-		case COMMAND_READ_MEMORY:
-		case COMMAND_READ_FLASH:
+		case COMMAND_TAKE_SNAPSHOT:
 
-			if(parseReadArgs(argc, argv, &address, &size, NULL, &fileFormat, &intelHex, &file, &buffer) != 0)
+			if(argc < 4)
 				break;
 
-			printf("reading %s...\n"
-					"  address: 0x%.8x\n"
-					"  size: %u\n",
-					(command == COMMAND_READ_MEMORY) ? "memory" : "flash", address, size);
+			for(i = 4; i < argc; i++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[i]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[i]);
+					goto done;
+				}
+			}
 
-			if(command == COMMAND_READ_MEMORY)
-				result = ccdbg_readMemory(&info, address, size, buffer);
-			else
-				result = ccdbg_readFlash(&info, address, size, buffer);
+			if(parseCodeAddress(argv[3], &symbols, &address) != 0)
+				break;
 
-			okay = (result > 0);
+			if((snapshot = (CCDBG_SNAPSHOT *)malloc(sizeof(CCDBG_SNAPSHOT))) == NULL)
+				break;
 
-			printf("\n>> ");
+			printf("taking snapshot...\n"
+					"  stop address: 0x%.4x\n",
+					address);
+
+			if(runToAddress(&info, address) != 0)
+			{
+				printf("\n>> FAILED to reach the stop address\n");
+				goto done;
+			}
+
+			startTime = ccdbgDevice_getMicroseconds();
+			okay = (ccdbg_takeSnapshot(&info, snapshot) == 0);
+			now = ccdbgDevice_getMicroseconds() - startTime;
+
+			if(okay && saveSnapshot(argv[2], info.id, snapshot) != 0)
+			{
+				printf("\n>> FAILED to save snapshot to \"%s\"\n", argv[2]);
+				okay = 0;
+				goto done;
+			}
+
+			printf("\n>> %s", okay ? "OK" : "FAILED");
 
 			if(okay)
-				saveReadData(argc, argv, address, result, fileFormat, &intelHex, file, buffer);
-			else
-				printf("FAILED\n");
+				printf(", %u bytes of SRAM and PC 0x%.4x in %.1f ms", snapshot->sramSize, snapshot->pc, now / 1000.0);
+
+			printf("\n");
 
 			goto done;
 
-		case COMMAND_READ_FLASH_PAGE:
+		case COMMAND_RESTORE_SNAPSHOT:
 
-			size = info.flashPageSize;
+			if(argc != 3)
+				break;
 
-			if(parseReadArgs(argc, argv, &address, &size, &page, &fileFormat, &intelHex, &file, &buffer) != 0)
+			if((snapshot = (CCDBG_SNAPSHOT *)malloc(sizeof(CCDBG_SNAPSHOT))) == NULL)
 				break;
 
-			printf("reading flash page...\n"
-					"  page: %d\n"
-					"  address: 0x%.8x\n"
-					"  size: %u\n",
-					page, address, size);
+			if(loadSnapshot(argv[2], info.id, snapshot) != 0)
+			{
+				printf("FAILED to load snapshot of this chip from \"%s\"\n", argv[2]);
+				goto done;
+			}
 
-			result = ccdbg_readFlashPage(&info, page, buffer);
-			okay = (result == 0);
+			printf("restoring snapshot...\n"
+					"  PC: 0x%.4x\n",
+					snapshot->pc);
 
-			printf("\n>> ");
+			startTime = ccdbgDevice_getMicroseconds();
+			okay = (ccdbg_restoreSnapshot(&info, snapshot) == 0 && ccdbg_resume(&info) == 0);
+			now = ccdbgDevice_getMicroseconds() - startTime;
+
+			printf("\n>> %s", okay ? "OK" : "FAILED");
 
 			if(okay)
-				saveReadData(argc, argv, address, size, fileFormat, &intelHex, file, buffer);
-			else
-				printf("FAILED\n");
+				printf(" in %.1f ms", now / 1000.0);
+
+			printf("\n");
 
 			goto done;
 
-		case COMMAND_WRITE_MEMORY:
-		case COMMAND_WRITE_FLASH:
+		case COMMAND_GDB_SERVER:
 
-			if(parseWriteArgs(argc, argv, &address, &size, NULL, &verify, &intelHex, &file, &buffer, &intelHexMemory) != 0)
+			if(argc != 3)
 				break;
 
-			while(1)
-			{
-				printf("writing %s...\n"
-						"  address: 0x%.8x\n"
-						"  size: %u\n"
-						"  verify: %d\n",
-						(command == COMMAND_WRITE_MEMORY) ? "memory" : "flash",
-						address, size, verify);
+			printf("waiting for GDB on %s...\n", argv[2]);
+			fflush(stdout);
 
-				if(command == COMMAND_WRITE_MEMORY)
-					result = ccdbg_writeMemory(&info, address, size, buffer, verify);
-				else
-					result = ccdbg_writeFlash(&info, address, size, buffer, verify);
+			okay = (gdbServer_serve(&info, argv[2], &gdbServerStatistics) == 0);
 
-				okay = (result > 0);
+			printf("\n>> %s after %u packets\n"
+					"   cache: %u hits, %u misses, %u lines read ahead, %u reads from the chip\n",
+					okay ? "OK" : "FAILED", gdbServerStatistics.packets, gdbServerStatistics.cacheHits,
+					gdbServerStatistics.cacheMisses, gdbServerStatistics.readahead, gdbServerStatistics.targetReads);
 
-				printf("\n>> ");
+			goto done;
 
-				if(okay)
-					printf("%d bytes written\n", result);
-				else
-				{
-					printf("FAILED\n");
+		case COMMAND_WAIT_FOR_HALT:
+
+			if(argc < 3)
+				break;
+
+			size = 0;
+			i = 3;
+
+			if(argc > 3 && isdigit(argv[3][0]))
+			{
+				if(stringToNumber(argv[3], &size, "") != 0)
 					break;
+
+				++i;
+			}
+
+			for(; i < argc; i++)
+			{
+				if(sdcc_loadSymbols(&symbols, argv[i]) != 0)
+				{
+					printf("FAILED to load symbols from \"%s\"\n", argv[i]);
+					goto done;
 				}
+			}
 
-				if(intelHexMemory == NULL)
-					break;
+			if(parseCodeAddress(argv[2], &symbols, &address) != 0 || size > 0xffffffff / 1000)
+				break;
 
-				printf("\n");
+			printf("waiting for halt...\n"
+					"  stop address: 0x%.4x\n",
+					address);
 
-				okay = 0;
-				address = intelHexMemory->baseAddress;
-				intelHexMemory = intelHexMemory->next;
+			if(size > 0)
+				printf("  timeout: %u ms\n", size);
 
-				if(size > intelHexMemory->size)
-				{
-					free(buffer);
+			if(ccdbg_setBreakpoint(&info, 0, address, 1) != 0 || ccdbg_resume(&info) != 0)
+			{
+				printf("\n>> FAILED to start the CPU\n");
+				goto done;
+			}
 
-					if((buffer = (unsigned char *)malloc(size)) == NULL)
-						break;
-				}
+			startTime = ccdbgDevice_getMicroseconds();
+			result = ccdbg_waitForHalt(&info, size * 1000, &count);
+			now = ccdbgDevice_getMicroseconds() - startTime;
 
-				size = intelHexMemory->size;
+			if(result > 0)
+			{
+				okay = ((result = ccdbg_getPc(&info)) >= 0 && ccdbg_setBreakpoint(&info, 0, 0, 0) == 0);
 
-				if(intelHex_copyDataFromHexInfo(&intelHex, address, buffer, NULL, size) != 0)
-					break;
+				printf("\n>> %s", okay ? "OK" : "FAILED");
+
+				if(okay)
+					printf(", halted at 0x%.4x after %.3f seconds, noticed within %u us", result, now / 1000000.0, count);
+
+				printf("\n");
+			}
+			else
+			{
+				/**
+				 * leave the chip halted and without the breakpoint, as a halt at it would
+				 */
+				if(result == 0 && (ccdbg_halt(&info) != 0 || ccdbg_setBreakpoint(&info, 0, 0, 0) != 0))
+					result = -1;
+
+				printf("\n>> %s after %.3f seconds\n", (result == 0) ? "TIMED OUT" : "FAILED", now / 1000000.0);
 			}
 
 			goto done;
 
-		case COMMAND_WRITE_FLASH_PAGE:
+		case COMMAND_DIGEST:
 
-			size = info.flashPageSize;
+			if(argc != 4)
+				break;
 
-			if(parseWriteArgs(argc, argv, &address, &size, &page, &verify, &intelHex, &file, &buffer, NULL) != 0)
+			if(strcmp(argv[2], "hex") == 0)
+				fileFormat = INTEL_HEX_FORMAT_HEX;
+			else if(strcmp(argv[2], "bin") == 0)
+				fileFormat = INTEL_HEX_FORMAT_BIN;
+			else
 				break;
 
-			printf("writing flash page...\n"
-					"  page: %d\n"
-					"  address: 0x%.8x\n"
-					"  size: %u\n"
-					"  verify: %d\n",
-					page, address, size, verify);
+			if(intelHex_convert(fileFormat, argv[3], NULL, 0, NULL, &intelHex, INTEL_HEX_IGNORE_UNKNOWN_RECORD) != 0)
+				break;
 
-			result = ccdbg_writeFlashPage(&info, page, buffer, verify);
-			okay = (result == 0);
+			if(intelHex_getDigests(&intelHex, info.flashPageSize, &digests, &count, &imageDigest) != 0)
+			{
+				printf("FAILED to compute the digests of \"%s\"\n", argv[3]);
+				goto done;
+			}
 
-			printf("\n>> %s\n", okay ? "OK" : "FAILED");
+			printf("comparing flash by page digests...\n"
+					"  file: %s\n"
+					"  pages: %u\n\n"
+					"  page     crc16  hash              flash\n"
+					"  -------- -----  ----------------  -----\n",
+					argv[3], count);
+
+			okay = 1;
+			size = 0;
+
+			for(i = 0; i < (int)count; i++)
+			{
+				printf("  %8u 0x%.4x %.16llx  ", digests[i].page, digests[i].crc, (unsigned long long)digests[i].hash);
+
+				if(digests[i].page >= info.numberOfFlashPages)
+				{
+					printf("past flash\n");
+					++size;
+					continue;
+				}
+
+				if((result = ccdbg_getFlashPageCrc(&info, digests[i].page)) < 0)
+				{
+					printf("FAILED\n");
+					okay = 0;
+					break;
+				}
+
+				if(result == digests[i].crc)
+					printf("same\n");
+				else
+				{
+					printf("DIFFERENT (0x%.4x)\n", result);
+					++size;
+				}
+			}
+
+			printf("\n  image: %u pages, crc16 0x%.4x, hash %.16llx\n",
+					imageDigest.page, imageDigest.crc, (unsigned long long)imageDigest.hash);
+
+			printf("\n>> ");
+
+			if(!okay)
+				printf("FAILED\n");
+			else if(size == 0)
+				printf("flash is the SAME as the file\n");
+			else
+				printf("%u of %u pages are DIFFERENT\n", size, count);
 
 			goto done;
 
@@ -1006,7 +3232,20 @@ int main(int argc, char **argv)
 	if(file != NULL)
 		fclose(file);
 
+	if(histogram != NULL)
+		free(histogram);
+
+	if(pcs != NULL)
+		free(pcs);
+
+	if(snapshot != NULL)
+		free(snapshot);
+
+	if(digests != NULL)
+		free(digests);
+
 	intelHex_destroyHexInfo(&intelHex);
+	sdcc_destroySymbols(&symbols);
 	ccdbgDevice_destroy();
 
 	return (okay ? 0 : -1);
@@ -23,6 +23,8 @@
  * 05may2014
  */
 
+#include <time.h>
+#include <unistd.h>
 #include "ccdbg.h"
 #include "GPIO.h"
 
@@ -64,3 +66,16 @@ void ccdbgDevice_delay(void)
 {
 	// no operation
 }
+
+void ccdbgDevice_sleep(unsigned int microseconds)
+{
+	usleep(microseconds);
+}
+
+unsigned long long ccdbgDevice_getMicroseconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
@@ -28,6 +28,7 @@
  */
 
 #include "ccdbg.h"
+#include <string.h>
 
 int ccdbg_retries = 1;
 
@@ -75,6 +76,8 @@ static unsigned int readByte(void)
 
 void ccdbg_reset(void)
 {
+	ccdbg_invalidateCache();
+
 	CCDBG_RESET_OUT();
 	CCDBG_DC_OUT();
 	CCDBG_RESET_HIGH();
@@ -88,7 +91,7 @@ void ccdbg_reset(void)
 	CCDBG_DELAY();
 }
 
-int ccdbg_command(CCDBG_COMMAND command, unsigned int inputDataSize, const unsigned char *inputData, unsigned int *outputDataSize, unsigned short *outputData, int retries)
+static int issueCommand(CCDBG_COMMAND command, unsigned int inputDataSize, const unsigned char *inputData, unsigned int *outputDataSize, unsigned short *outputData, int retries)
 {
 	unsigned int _outputDataSize;
 	unsigned short _outputData;
@@ -187,6 +190,43 @@ static struct {
 
 #define MAXIMUM_FLASH_PAGE_SIZE		KB(2)
 #define FLASH_PAGE_LOCK_BITS_SIZE	16
+#define MAXIMUM_BURST_SIZE			KB(2)
+#define MAXIMUM_DMA_LENGTH			8191
+#define MINIMUM_BURST_WRITE_SIZE	16
+#define MINIMUM_HALT_POLL_INTERVAL	100		// microseconds
+#define MAXIMUM_HALT_POLL_INTERVAL	10000
+#define DMA_TIMEOUT					100000	// microseconds
+
+/**
+ * write-through cache of chip state that the flash engine would otherwise
+ *   read or write over and over again
+ */
+enum {
+	STATE_MEMCTR	= 0x01,
+	STATE_CONFIG	= 0x02,
+	STATE_LOCK_BITS	= 0x04
+};
+
+static struct {
+	unsigned int valid;
+	unsigned char memctr;
+	unsigned char config;
+	unsigned char lockBits[FLASH_PAGE_LOCK_BITS_SIZE];
+} state;
+
+/**
+ * contents of recently read or written flash pages, least recently used
+ *   entry is replaced first; an entry with lastUsed of 0 is free
+ */
+#define FLASH_PAGE_CACHE_SIZE	8
+
+static struct {
+	unsigned int page;
+	unsigned int lastUsed;
+	unsigned char data[MAXIMUM_FLASH_PAGE_SIZE];
+} pageCache[FLASH_PAGE_CACHE_SIZE];
+
+static unsigned int pageCacheClock;
 
 enum {
 	REG_CHIPID		= 0x624a,
@@ -202,6 +242,9 @@ enum {
 	REG_DMA0CFGL	= 0x70d4,
 	REG_DMA0CFGH	= 0x70d5,
 	REG_DMAARM		= 0x70d6,
+	REG_DMAREQ		= 0x70d7,
+	REG_RNDL		= 0x70bc,
+	REG_RNDH		= 0x70bd,
 	REG_XDATA		= 0x8000
 };
 
@@ -214,8 +257,193 @@ enum {
 	FCTL_CM			= 0x04
 };
 
+enum {
+	MEMCTR_XMAP		= 0x08
+};
+
+/**
+ * SFRs are mirrored in XDATA at 0x7080 ~ 0x70ff and are reachable there
+ *   with a single direct-addressing instruction
+ */
+#define SFR_WINDOW_START	0x7080
+#define SFR_WINDOW_END		0x7100
+#define NO_ADDRESS			((unsigned int)-1)
+
+enum {
+	SFR_DPL0	= 0x82,
+	SFR_DPH0	= 0x83,
+	SFR_DPL1	= 0x84,
+	SFR_DPH1	= 0x85,
+	SFR_DPS		= 0x92,
+	SFR_ACC		= 0xe0
+};
+
+#define IS_SFR_ADDRESS(address) \
+	((address) >= SFR_WINDOW_START && (address) < SFR_WINDOW_END)
+
+/**
+ * SFRs that do more than hold a value when read or written, left out of
+ *   snapshots
+ */
+enum {
+	SIDE_EFFECT_READ	= 0x01,
+	SIDE_EFFECT_WRITE	= 0x02
+};
+
+static const struct {
+	unsigned char sfr;
+	unsigned char sideEffects;
+} sfrSideEffects[] = {
+		{ 0x87, SIDE_EFFECT_WRITE },						// PCON, IDLE enters a power mode
+		{ 0x95, SIDE_EFFECT_WRITE },						// ST0, ST1, and ST2 set the sleep timer compare value
+		{ 0x96, SIDE_EFFECT_WRITE },
+		{ 0x97, SIDE_EFFECT_WRITE },
+		{ 0xa2, SIDE_EFFECT_WRITE },						// T2M0 ~ T2MOVF2, MAC timer registers selected by T2MSEL
+		{ 0xa3, SIDE_EFFECT_WRITE },
+		{ 0xa4, SIDE_EFFECT_WRITE },
+		{ 0xa5, SIDE_EFFECT_WRITE },
+		{ 0xa6, SIDE_EFFECT_WRITE },
+		{ 0xb1, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE },		// ENCDI and ENCDO, AES FIFOs
+		{ 0xb2, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE },
+		{ 0xb3, SIDE_EFFECT_WRITE },						// ENCCS, starts AES commands
+		{ 0xb4, SIDE_EFFECT_WRITE },						// ADCCON1, starts conversions and random number steps
+		{ 0xb6, SIDE_EFFECT_WRITE },						// ADCCON3, starts an extra conversion
+		{ 0xbb, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE },		// ADCH, clears ADCCON1.EOC
+		{ 0xbc, SIDE_EFFECT_WRITE },						// RNDL and RNDH, seed and CRC input
+		{ 0xbd, SIDE_EFFECT_WRITE },
+		{ 0xc1, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE },		// U0DBUF
+		{ 0xc9, SIDE_EFFECT_WRITE },						// WDCTL, starts or feeds the watchdog
+		{ 0xd6, SIDE_EFFECT_WRITE },						// DMAARM
+		{ 0xd7, SIDE_EFFECT_WRITE },						// DMAREQ
+		{ 0xd9, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE },		// RFD, radio FIFOs
+		{ 0xe1, SIDE_EFFECT_WRITE },						// RFST, radio command strobes
+		{ 0xe2, SIDE_EFFECT_WRITE },						// T1CNTL and T1CNTH, clear Timer 1
+		{ 0xe3, SIDE_EFFECT_WRITE },
+		{ 0xf9, SIDE_EFFECT_READ | SIDE_EFFECT_WRITE }		// U1DBUF
+};
+
+/**
+ * registers used by the memory access instructions, as far as they are
+ *   known; if DPS is unknown (-1), only the active data pointer is tracked
+ *   and it is kept in dptr[0]
+ */
+static struct {
+	int dps;
+	unsigned int dptr[2];
+	int acc;
+} cpu = { -1, { NO_ADDRESS, NO_ADDRESS }, -1 };
+
+/**
+ * registers of the halted firmware, saved right before debug instructions
+ *   first change them and restored before the CPU runs again; -1 and
+ *   NO_ADDRESS for those not saved
+ */
+static struct {
+	int active;
+	int acc;
+	int dps;
+	unsigned int dptr[2];
+} context;
+
+static unsigned int instructionCount;
+
 #define executeInstruction(size, instruction) \
-	ccdbg_command(CCDBG_COMMAND_DEBUG_INSTR, size, instruction, 0, 0, ccdbg_retries)
+	issueCommand(CCDBG_COMMAND_DEBUG_INSTR, size, instruction, 0, 0, ccdbg_retries)
+
+void ccdbg_invalidateCache(void)
+{
+	int i;
+
+	state.valid = 0;
+
+	cpu.dps = -1;
+	cpu.dptr[0] = NO_ADDRESS;
+	cpu.dptr[1] = NO_ADDRESS;
+	cpu.acc = -1;
+
+	context.active = 0;
+
+	for(i = 0; i < FLASH_PAGE_CACHE_SIZE; i++)
+		pageCache[i].lastUsed = 0;
+}
+
+int ccdbg_command(CCDBG_COMMAND command, unsigned int inputDataSize, const unsigned char *inputData, unsigned int *outputDataSize, unsigned short *outputData, int retries)
+{
+	switch(command)
+	{
+	case CCDBG_COMMAND_RD_CONFIG:
+	case CCDBG_COMMAND_GET_PC:
+	case CCDBG_COMMAND_READ_STATUS:
+	case CCDBG_COMMAND_HALT:
+	case CCDBG_COMMAND_GET_BM:
+	case CCDBG_COMMAND_GET_CHIP_ID:
+		break;
+
+	/**
+	 * these change the debug configuration only
+	 */
+	case CCDBG_COMMAND_WR_CONFIG:
+		state.valid &= ~STATE_CONFIG;
+		break;
+
+	case CCDBG_COMMAND_SET_HW_BRKPNT:
+		break;
+
+	default:
+		/**
+		 * anything else may change the state of the chip behind our back
+		 */
+		ccdbg_invalidateCache();
+		break;
+	}
+
+	return issueCommand(command, inputDataSize, inputData, outputDataSize, outputData, retries);
+}
+
+static unsigned char * findCachedFlashPage(unsigned int page)
+{
+	int i;
+
+	for(i = 0; i < FLASH_PAGE_CACHE_SIZE; i++)
+	{
+		if(pageCache[i].lastUsed != 0 && pageCache[i].page == page)
+		{
+			pageCache[i].lastUsed = ++pageCacheClock;
+			return pageCache[i].data;
+		}
+	}
+
+	return 0;
+}
+
+static void uncacheFlashPage(unsigned int page)
+{
+	int i;
+
+	for(i = 0; i < FLASH_PAGE_CACHE_SIZE; i++)
+	{
+		if(pageCache[i].page == page)
+			pageCache[i].lastUsed = 0;
+	}
+}
+
+static unsigned char * allocateCachedFlashPage(unsigned int page)
+{
+	int entry = 0;
+	int i;
+
+	uncacheFlashPage(page);
+
+	for(i = 1; i < FLASH_PAGE_CACHE_SIZE; i++)
+	{
+		if(pageCache[i].lastUsed < pageCache[entry].lastUsed)
+			entry = i;
+	}
+
+	pageCache[entry].page = page;
+	pageCache[entry].lastUsed = ++pageCacheClock;
+	return pageCache[entry].data;
+}
 
 CCDBG_ID ccdbg_identifyChip(CCDBG_ID id)
 {
@@ -230,10 +458,19 @@ CCDBG_ID ccdbg_identifyChip(CCDBG_ID id)
 	 */
 	ccdbg_reset();
 
+	/**
+	 * the CPU is halted with its registers at their reset values
+	 */
+	cpu.dps = context.dps = 0;
+	cpu.dptr[0] = context.dptr[0] = 0x0000;
+	cpu.dptr[1] = context.dptr[1] = 0x0000;
+	cpu.acc = context.acc = 0x00;
+	context.active = 1;
+
 	/**
 	 * get the chip's ID and version
 	 */
-	if(ccdbg_command(CCDBG_COMMAND_GET_CHIP_ID, 0, 0, 0, (unsigned short *)id, ccdbg_retries) < 0)
+	if(issueCommand(CCDBG_COMMAND_GET_CHIP_ID, 0, 0, 0, (unsigned short *)id, ccdbg_retries) < 0)
 		return CCDBG_INVALID_ID;
 
 	/**
@@ -248,7 +485,7 @@ CCDBG_ID ccdbg_identifyChip(CCDBG_ID id)
 	/**
 	 * get debug interface lock status
 	 */
-	if((value = ccdbg_command(CCDBG_COMMAND_READ_STATUS, 0, 0, 0, 0, ccdbg_retries)) < 0)
+	if((value = issueCommand(CCDBG_COMMAND_READ_STATUS, 0, 0, 0, 0, ccdbg_retries)) < 0)
 		return CCDBG_INVALID_ID;
 
 	if((id->isLocked = (value & CCDBG_STATUS_DEBUG_LOCKED)))
@@ -263,203 +500,1358 @@ CCDBG_ID ccdbg_identifyChip(CCDBG_ID id)
 		return id;
 	}
 
-	/**
-	 * verify the returned chip ID
-	 */
-	if(ccdbg_readMemory(id, REG_CHIPID, 0, 0) != (unsigned int)id->id)
-		return CCDBG_INVALID_ID;
+	/**
+	 * verify the returned chip ID
+	 */
+	if(ccdbg_readMemory(id, REG_CHIPID, 0, 0) != (unsigned int)id->id)
+		return CCDBG_INVALID_ID;
+
+	/**
+	 * verify the returned chip version
+	 */
+	if(ccdbg_readMemory(id, REG_CHVER, 0, 0) != (unsigned int)id->rev)
+		return CCDBG_INVALID_ID;
+
+	/**
+	 * get the size of the chip's flash memory
+	 */
+	if((value = ccdbg_readMemory(id, REG_CHIPINFO0, 0, 0)) < 0)
+		return CCDBG_INVALID_ID;
+
+	value >>= 4;
+	id->flashSize = (id->id == CCDBG_CHIP_ID_CC2533 && value == 0x3) ? KB(96) : (KB(16) << value);
+	id->writableFlashSize = id->flashSize - FLASH_PAGE_LOCK_BITS_SIZE;
+
+	/**
+	 * get the bank size and page size of the chip's flash memory
+	 */
+	id->flashBankSize = KB(32);
+	id->flashPageSize = chip[i].flashPageSize;
+
+	/**
+	 * compute number of flash pages
+	 */
+	id->numberOfFlashPages = (id->flashSize + (id->flashPageSize - 1)) / id->flashPageSize;
+
+	/**
+	 * get the size of the chip's SRAM
+	 */
+	if((value = ccdbg_readMemory(id, REG_CHIPINFO1, 0, 0)) < 0)
+		return CCDBG_INVALID_ID;
+
+	id->sramSize = KB(((value & 0x7) + 1));
+
+	/**
+	 * if applicable, get the chip's IEEE address
+	 */
+	switch(id->id)
+	{
+	case CCDBG_CHIP_ID_CC2530:
+	case CCDBG_CHIP_ID_CC2531:
+	case CCDBG_CHIP_ID_CC2533:
+		id->ieeeAddressLength = 8;
+		value = 0x780c;
+		break;
+
+	case CCDBG_CHIP_ID_CC2540:
+	case CCDBG_CHIP_ID_CC2541:
+		id->ieeeAddressLength = 6;
+		value = 0x780e;
+		break;
+
+	default:
+		id->ieeeAddressLength = 0;
+		break;
+	}
+
+	if(id->ieeeAddressLength > 0)
+	{
+		if(ccdbg_readMemory(id, (unsigned int)value, id->ieeeAddressLength, id->ieeeAddress) < 0)
+			return CCDBG_INVALID_ID;
+	}
+
+	return id;
+}
+
+int ccdbg_executeInstruction(CCDBG_ID id, unsigned int size, const unsigned char *instruction)
+{
+	ccdbg_invalidateCache();
+	return executeInstruction(size, instruction);
+}
+
+static int emitInstruction(unsigned int size, const unsigned char *instruction)
+{
+	int value;
+
+	if((value = executeInstruction(size, instruction)) < 0)
+	{
+		ccdbg_invalidateCache();
+		return -1;
+	}
+
+	++instructionCount;
+	return value;
+}
+
+static void beginContext(void)
+{
+	/**
+	 * whatever ran before the CPU halted changed whatever has been cached
+	 */
+	ccdbg_invalidateCache();
+
+	context.active = 1;
+	context.acc = -1;
+	context.dps = -1;
+	context.dptr[0] = NO_ADDRESS;
+	context.dptr[1] = NO_ADDRESS;
+}
+
+static int preserveAccumulator(void)
+{
+	static unsigned char instruction = 0x00;
+	int value;
+
+	if(!context.active || context.acc >= 0)
+		return 0;
+
+	/**
+	 * NOP
+	 */
+	if((value = emitInstruction(1, &instruction)) < 0)
+		return -1;
+
+	context.acc = cpu.acc = value;
+	return 0;
+}
+
+static int preserveDataPointers(void)
+{
+	static const unsigned char sfr[] = { SFR_DPS, SFR_DPL0, SFR_DPH0, SFR_DPL1, SFR_DPH1 };
+	unsigned char instruction[] = { 0xe5, 0x00 };
+	int value[sizeof(sfr)];
+	unsigned int i;
+
+	if(!context.active || context.dps >= 0)
+		return 0;
+
+	if(preserveAccumulator() != 0)
+		return -1;
+
+	for(i = 0; i < sizeof(sfr); i++)
+	{
+		/**
+		 * MOV A,direct
+		 *   direct is the SFR address
+		 */
+		instruction[1] = sfr[i];
+
+		if((value[i] = emitInstruction(2, instruction)) < 0)
+			return -1;
+	}
+
+	cpu.acc = value[4];
+	context.dps = cpu.dps = value[0] & 0x1;
+	context.dptr[0] = cpu.dptr[0] = (value[2] << 8) | value[1];
+	context.dptr[1] = cpu.dptr[1] = (value[4] << 8) | value[3];
+
+	return 0;
+}
+
+static int endContext(void)
+{
+	unsigned char instruction1[] = { 0x75, SFR_DPS, 0x00 };
+	unsigned char instruction2[] = { 0x90, 0x00, 0x00 };
+	unsigned char instruction3[] = { 0x74, (unsigned char)(context.acc & 0xff) };
+	int i;
+
+	if(!context.active)
+		return 0;
+
+	for(i = 0; i < 2 && context.dps >= 0; i++)
+	{
+		if(cpu.dps >= 0 && cpu.dptr[i] == context.dptr[i])
+			continue;
+
+		if(cpu.dps != i)
+		{
+			/**
+			 * MOV DPS,#data
+			 *   #data is i
+			 */
+			instruction1[2] = i;
+
+			if(emitInstruction(3, instruction1) < 0)
+				return -1;
+
+			cpu.dps = i;
+		}
+
+		/**
+		 * MOV DPTR,#data16
+		 *   #data16 is the saved data pointer
+		 */
+		instruction2[1] = (context.dptr[i] >> 8) & 0xff;
+		instruction2[2] = context.dptr[i] & 0xff;
+
+		if(emitInstruction(3, instruction2) < 0)
+			return -1;
+
+		cpu.dptr[i] = context.dptr[i];
+	}
+
+	if(context.dps >= 0 && cpu.dps != context.dps)
+	{
+		instruction1[2] = context.dps;
+
+		if(emitInstruction(3, instruction1) < 0)
+			return -1;
+
+		cpu.dps = context.dps;
+	}
+
+	if(context.acc >= 0 && cpu.acc != context.acc)
+	{
+		/**
+		 * MOV A,#data
+		 *   #data is the saved accumulator
+		 */
+		if(emitInstruction(2, instruction3) < 0)
+			return -1;
+
+		cpu.acc = context.acc;
+	}
+
+	context.active = 0;
+	return 0;
+}
+
+/**
+ * number of operations, including the current one, checked for addresses
+ *   that are still to be accessed
+ */
+#define LOOKAHEAD_OPERATIONS	4
+
+static int isAddressUpcoming(const CCDBG_MEMORY_OPERATION *operations, unsigned int count, unsigned int address)
+{
+	unsigned int i;
+
+	if(address == NO_ADDRESS)
+		return 0;
+
+	if(count > LOOKAHEAD_OPERATIONS)
+		count = LOOKAHEAD_OPERATIONS;
+
+	/**
+	 * only an exact match counts; switching to a data pointer and then
+	 *   incrementing it costs more than loading the address
+	 */
+	for(i = 0; i < count; i++)
+	{
+		if(address == operations[i].address)
+			return 1;
+
+		if(operations[i].type == CCDBG_MEMORY_COPY && address == operations[i].sourceAddress)
+			return 1;
+	}
+
+	return 0;
+}
+
+static int pointTo(unsigned int address, const CCDBG_MEMORY_OPERATION *operations, unsigned int count)
+{
+	unsigned char instruction1[] = { 0x90, (unsigned char)((address >> 8) & 0xff), (unsigned char)(address & 0xff) };
+	static unsigned char instruction2 = 0xa3;
+	static unsigned char instruction3[] = { 0x05, SFR_DPS };
+	int active;
+
+	if(preserveDataPointers() != 0)
+		return -1;
+
+	active = (cpu.dps < 0) ? 0 : cpu.dps;
+
+	/**
+	 * costs on the wire, command and response bytes included: INC DPTR is
+	 *   3 bytes, INC DPS is 4 bytes, and MOV DPTR,#data16 is 5 bytes
+	 */
+
+	if(cpu.dptr[active] == address)
+		return 0;
+
+	if(cpu.dptr[active] != NO_ADDRESS && (cpu.dptr[active] + 1) == address)
+	{
+		/**
+		 * INC DPTR
+		 */
+		if(emitInstruction(1, &instruction2) < 0)
+			return -1;
+
+		cpu.dptr[active] = address;
+		return 0;
+	}
+
+	if(cpu.dps >= 0 && (cpu.dptr[active ^ 1] == address ||
+			(isAddressUpcoming(operations, count, cpu.dptr[active]) && !isAddressUpcoming(operations, count, cpu.dptr[active ^ 1]))))
+	{
+		/**
+		 * INC DPS
+		 *   switches between DPTR0 and DPTR1 as bits 7:1 of DPS are
+		 *   always 0; either the other data pointer is already there,
+		 *   or the active one is kept for an address still to come
+		 */
+		if(emitInstruction(2, instruction3) < 0)
+			return -1;
+
+		cpu.dps = active ^= 1;
+
+		if(cpu.dptr[active] == address)
+			return 0;
+	}
+
+	/**
+	 * MOV DPTR,#data16
+	 *   #data16 is address
+	 */
+	if(emitInstruction(3, instruction1) < 0)
+		return -1;
+
+	cpu.dptr[active] = address;
+	return 0;
+}
+
+static int preserveSfr(unsigned int sfr)
+{
+	switch(sfr)
+	{
+	case SFR_ACC:
+		return preserveAccumulator();
+
+	case SFR_DPS:
+	case SFR_DPL0:
+	case SFR_DPH0:
+	case SFR_DPL1:
+	case SFR_DPH1:
+		return preserveDataPointers();
+
+	default:
+		return 0;
+	}
+}
+
+static void updateSfr(unsigned int sfr, int value)
+{
+	/**
+	 * registers written on purpose keep their new values when the
+	 *   context is restored
+	 */
+	int keep = (context.active && value >= 0);
+
+	switch(sfr)
+	{
+	case SFR_ACC:
+		cpu.acc = value;
+
+		if(keep)
+			context.acc = value;
+
+		break;
+
+	case SFR_DPS:
+		if(cpu.dps < 0 || value < 0)
+		{
+			cpu.dptr[0] = NO_ADDRESS;
+			cpu.dptr[1] = NO_ADDRESS;
+		}
+
+		cpu.dps = (value < 0) ? -1 : (value & 0x1);
+
+		if(keep)
+			context.dps = value & 0x1;
+
+		break;
+
+	case SFR_DPL0:
+	case SFR_DPH0:
+	case SFR_DPL1:
+	case SFR_DPH1:
+		if(cpu.dps < 0)
+			cpu.dptr[0] = NO_ADDRESS;
+		else
+			cpu.dptr[(sfr == SFR_DPL0 || sfr == SFR_DPH0) ? 0 : 1] = NO_ADDRESS;
+
+		if(keep)
+		{
+			unsigned int *dptr = &context.dptr[(sfr == SFR_DPL0 || sfr == SFR_DPH0) ? 0 : 1];
+
+			if(sfr == SFR_DPL0 || sfr == SFR_DPL1)
+				*dptr = (*dptr & 0xff00) | value;
+			else
+				*dptr = (*dptr & 0x00ff) | (value << 8);
+		}
+
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int savedSfr(unsigned int sfr)
+{
+	if(!context.active)
+		return -1;
+
+	switch(sfr)
+	{
+	case SFR_ACC:
+		return context.acc;
+
+	case SFR_DPS:
+		return context.dps;
+
+	case SFR_DPL0:
+	case SFR_DPL1:
+		return (context.dps < 0) ? -1 : (context.dptr[(sfr == SFR_DPL0) ? 0 : 1] & 0xff);
+
+	case SFR_DPH0:
+	case SFR_DPH1:
+		return (context.dps < 0) ? -1 : ((context.dptr[(sfr == SFR_DPH0) ? 0 : 1] >> 8) & 0xff);
+
+	default:
+		return -1;
+	}
+}
+
+static int loadByte(unsigned int address, const CCDBG_MEMORY_OPERATION *operations, unsigned int count)
+{
+	unsigned char instruction1[] = { 0xe5, (unsigned char)(address & 0xff) };
+	static unsigned char instruction2 = 0xe0;
+	unsigned char instruction3[] = { 0x74, 0x00 };
+	static unsigned char instruction4 = 0x00;
+	int value;
+
+	if(preserveAccumulator() != 0)
+		return -1;
+
+	if(IS_SFR_ADDRESS(address))
+	{
+		if(preserveSfr(address & 0xff) != 0)
+			return -1;
+
+		/**
+		 * the halted firmware's value, not whatever debug instructions
+		 *   left in the register
+		 */
+		if((value = savedSfr(address & 0xff)) >= 0)
+		{
+			if(value != cpu.acc)
+			{
+				/**
+				 * MOV A,#data
+				 *   #data is the saved value
+				 */
+				instruction3[1] = value;
+
+				if(emitInstruction(2, instruction3) < 0)
+					return -1;
+
+				cpu.acc = value;
+			}
+
+			return value;
+		}
+
+		if((address & 0xff) == SFR_ACC)
+		{
+			/**
+			 * NOP
+			 *   MOV A,ACC is a reserved encoding, and a debug instruction
+			 *   returns the accumulator anyway
+			 */
+			if((value = emitInstruction(1, &instruction4)) < 0)
+				return -1;
+		}
+		else
+		{
+			/**
+			 * MOV A,direct
+			 *   direct is the SFR address
+			 */
+			if((value = emitInstruction(2, instruction1)) < 0)
+				return -1;
+		}
+	}
+	else
+	{
+		if(pointTo(address, operations, count) != 0)
+			return -1;
+
+		/**
+		 * MOVX A,@DPTR
+		 */
+		if((value = emitInstruction(1, &instruction2)) < 0)
+			return -1;
+	}
+
+	cpu.acc = value;
+	return value;
+}
+
+static int storeByte(unsigned int address, int value, const CCDBG_MEMORY_OPERATION *operations, unsigned int count)
+{
+	unsigned char instruction1[] = { 0x75, (unsigned char)(address & 0xff), (unsigned char)(value & 0xff) };
+	unsigned char instruction2[] = { 0xf5, (unsigned char)(address & 0xff) };
+	unsigned char instruction3[] = { 0x74, (unsigned char)(value & 0xff) };
+	static unsigned char instruction4 = 0xf0;
+
+	/**
+	 * value less than zero stores the accumulator as it is
+	 */
+
+	if(IS_SFR_ADDRESS(address))
+	{
+		if(preserveSfr(address & 0xff) != 0)
+			return -1;
+
+		if(value < 0 || value == cpu.acc)
+		{
+			/**
+			 * MOV direct,A
+			 *   direct is the SFR address
+			 */
+			if(emitInstruction(2, instruction2) < 0)
+				return -1;
+
+			value = cpu.acc;
+		}
+		else
+		{
+			/**
+			 * MOV direct,#data
+			 *   direct is the SFR address, #data is value
+			 */
+			if(emitInstruction(3, instruction1) < 0)
+				return -1;
+		}
+
+		updateSfr(address & 0xff, value);
+		return 0;
+	}
+
+	if(pointTo(address, operations, count) != 0)
+		return -1;
+
+	if(value >= 0 && value != cpu.acc)
+	{
+		/**
+		 * MOV A,#data
+		 *   #data is value
+		 */
+		if(emitInstruction(2, instruction3) < 0)
+			return -1;
+
+		cpu.acc = value;
+	}
+
+	/**
+	 * MOVX @DPTR,A
+	 */
+	if(emitInstruction(1, &instruction4) < 0)
+		return -1;
+
+	return 0;
+}
+
+int ccdbg_executeMemoryOperations(CCDBG_ID id, unsigned int count, const CCDBG_MEMORY_OPERATION *operations, CCDBG_MEMORY_STATISTICS *statistics)
+{
+	const CCDBG_MEMORY_OPERATION *operation;
+	unsigned int firstInstruction = instructionCount;
+	unsigned int plainInstructions = 0;
+	int status = 0;
+	int verify;
+	int value;
+	unsigned int i, j;
+
+	for(i = 0; i < count && status == 0; i++)
+	{
+		operation = &operations[i];
+
+		if(operation->data == 0 && operation->type != CCDBG_MEMORY_COPY && operation->size > 0)
+		{
+			status = -1;
+			break;
+		}
+
+		switch(operation->type)
+		{
+		case CCDBG_MEMORY_READ:
+
+			/**
+			 * plain: MOV DPTR, then MOVX A,@DPTR and INC DPTR for every byte
+			 */
+			plainInstructions += 2 * operation->size;
+
+			for(j = 0; j < operation->size; j++)
+			{
+				if((value = loadByte(operation->address + j, operation, count - i)) < 0)
+				{
+					status = -1;
+					break;
+				}
+
+				operation->data[j] = value;
+			}
+
+			break;
+
+		case CCDBG_MEMORY_WRITE:
+
+			/**
+			 * plain: MOV DPTR, then MOV A,#data, MOVX @DPTR,A, and INC DPTR
+			 *   for every byte
+			 */
+			plainInstructions += 3 * operation->size;
+
+			verify = ((i + 1) < count && operation[1].type == CCDBG_MEMORY_COMPARE &&
+					operation[1].address == operation->address && operation[1].size == operation->size &&
+					operation[1].data != 0 && memcmp(operation[1].data, operation->data, operation->size) == 0);
+
+			if(verify)
+			{
+				/**
+				 * plain: MOV DPTR and MOVX A,@DPTR for every byte
+				 */
+				plainInstructions += 2 * operation->size;
+				++i;
+			}
+
+			for(j = 0; j < operation->size; j++)
+			{
+				if(storeByte(operation->address + j, operation->data[j], operation, count - i) != 0)
+				{
+					status = -1;
+					break;
+				}
+
+				/**
+				 * read back while the data pointer is still there
+				 */
+				if(verify && loadByte(operation->address + j, operation, count - i) != operation->data[j])
+				{
+					status = -1;
+					break;
+				}
+			}
+
+			break;
+
+		case CCDBG_MEMORY_COMPARE:
+
+			/**
+			 * plain: MOV DPTR and MOVX A,@DPTR for every byte
+			 */
+			plainInstructions += 2 * operation->size;
+
+			for(j = 0; j < operation->size; j++)
+			{
+				if(loadByte(operation->address + j, operation, count - i) != operation->data[j])
+				{
+					status = -1;
+					break;
+				}
+			}
+
+			break;
+
+		case CCDBG_MEMORY_COPY:
+
+			/**
+			 * plain: MOV DPTR, MOVX A,@DPTR, MOV DPTR, and MOVX @DPTR,A
+			 *   for every byte
+			 */
+			plainInstructions += 4 * operation->size;
+
+			for(j = 0; j < operation->size; j++)
+			{
+				if(loadByte(operation->sourceAddress + j, operation, count - i) < 0 ||
+						storeByte(operation->address + j, -1, operation, count - i) != 0)
+				{
+					status = -1;
+					break;
+				}
+			}
+
+			break;
+
+		default:
+			status = -1;
+			break;
+		}
+	}
+
+	if(statistics != 0)
+	{
+		statistics->instructions = instructionCount - firstInstruction;
+		statistics->savedInstructions = (plainInstructions > statistics->instructions) ? (plainInstructions - statistics->instructions) : 0;
+	}
+
+	return status;
+}
+
+int ccdbg_readMemory(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
+{
+	CCDBG_MEMORY_OPERATION operation;
+	unsigned char _data;
+
+	switch(size)
+	{
+	case 0:
+		size = 1;
+		data = &_data;
+		break;
+
+	case 1:
+		if(data == 0)
+			data = &_data;
+
+		break;
+
+	default:
+		if(data == 0)
+			return -1;
+
+		break;
+	}
+
+	operation.type = CCDBG_MEMORY_READ;
+	operation.address = address;
+	operation.size = size;
+	operation.data = data;
+
+	if(ccdbg_executeMemoryOperations(id, 1, &operation, 0) != 0)
+		return -1;
+
+	return data[0];
+}
+
+int ccdbg_writeMemory(CCDBG_ID id, unsigned int address, unsigned int size, const unsigned char *data, int verify)
+{
+	CCDBG_MEMORY_OPERATION operation[2];
+	int coversMemctr = (address <= REG_MEMCTR && (address + size) > REG_MEMCTR);
+
+	if(coversMemctr)
+		state.valid &= ~STATE_MEMCTR;
+
+	/**
+	 * write, then compare if verifying
+	 */
+	operation[0].type = CCDBG_MEMORY_WRITE;
+	operation[1].type = CCDBG_MEMORY_COMPARE;
+	operation[0].address = operation[1].address = address;
+	operation[0].size = operation[1].size = size;
+	operation[0].data = operation[1].data = (unsigned char *)data;
+
+	if(ccdbg_executeMemoryOperations(id, verify ? 2 : 1, operation, 0) != 0)
+		return -1;
+
+	if(coversMemctr)
+	{
+		state.memctr = data[REG_MEMCTR - address];
+		state.valid |= STATE_MEMCTR;
+	}
+
+	return 0;
+}
+
+static int selectFlashBank(CCDBG_ID id, unsigned char bank)
+{
+	if((state.valid & STATE_MEMCTR) && state.memctr == bank)
+		return 0;
+
+	return ccdbg_writeMemory(id, REG_MEMCTR, 1, &bank, 1);
+}
+
+static int enableDma(CCDBG_ID id)
+{
+	int value;
+
+	if(!(state.valid & STATE_CONFIG))
+	{
+		if((value = issueCommand(CCDBG_COMMAND_RD_CONFIG, 0, 0, 0, 0, ccdbg_retries)) < 0)
+			return -1;
+
+		state.config = (unsigned char)value;
+		state.valid |= STATE_CONFIG;
+	}
+
+	if(!(state.config & CCDBG_CONFIG_DMA_PAUSED))
+		return 0;
+
+	value = state.config & ~CCDBG_CONFIG_DMA_PAUSED;
+	state.valid &= ~STATE_CONFIG;
+
+	if((value = issueCommand(CCDBG_COMMAND_WR_CONFIG, 1, (unsigned char *)&value, 0, 0, ccdbg_retries)) < 0)
+		return -1;
+
+	if((value & (CCDBG_STATUS_CHIP_ERASE_BUSY | CCDBG_STATUS_PCON_IDLE | CCDBG_STATUS_PM_ACTIVE | CCDBG_STATUS_DEBUG_LOCKED)))
+		return -1;
+
+	state.config &= ~CCDBG_CONFIG_DMA_PAUSED;
+	state.valid |= STATE_CONFIG;
+	return 0;
+}
+
+int ccdbg_burstWriteMemory(CCDBG_ID id, unsigned int address, unsigned int size, const unsigned char *data, int verify)
+{
+	unsigned char descriptorData[] = {
+			0x62, 0x60,			// source: DBGDATA (0x6260)
+			0x00, 0x00,			// destination: address
+			0x00, 0x00,			// length
+			31,					// trigger: DBG_BW
+			0x11				// source increment: 0, destination increment: 1, priority: assured
+	};
+
+	static unsigned char dmaarmValue = 0x01;	// arm DMA0
+	unsigned char descriptorAddress[2];			// DMA0 descriptor address
+	CCDBG_MEMORY_OPERATION operation;
+	unsigned int chunks;
+	unsigned int length;
+	unsigned int burstSize;
+	unsigned int bytes;
+	int value;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked || data == 0)
+		return -1;
+
+	/**
+	 * the DMA descriptor is placed at the destination itself, which the
+	 *   payload overwrites once the channel has been armed and the
+	 *   descriptor loaded; so only SRAM destinations large enough to be
+	 *   worth the setup go through DMA
+	 */
+	if(size < MINIMUM_BURST_WRITE_SIZE || address < (CCDBG_SRAM_END - id->sramSize) || (address + size) > CCDBG_SRAM_END)
+		return ccdbg_writeMemory(id, address, size, data, verify);
+
+	/**
+	 * enable DMA transfers via the debug configuration register
+	 */
+	if(enableDma(id) != 0)
+		return -1;
+
+	/**
+	 * chunks are balanced, rather than full ones and a remainder, so each
+	 *   one is large enough for its descriptor to be wholly overwritten, e.g.
+	 *   8192 bytes go as 4096 + 4096 and not as 8191 + 1
+	 */
+	chunks = (size + MAXIMUM_DMA_LENGTH - 1) / MAXIMUM_DMA_LENGTH;
+
+	while(size > 0)
+	{
+		length = (size + chunks - 1) / chunks;
+		--chunks;
+
+		if(length < sizeof(descriptorData))
+			return -1;
+
+		/**
+		 * write DMA descriptor data to the destination
+		 */
+		descriptorData[2] = (address >> 8) & 0xff;
+		descriptorData[3] = address & 0xff;
+		descriptorData[4] = (length >> 8) & 0x1f;
+		descriptorData[5] = length & 0xff;
+
+		if(ccdbg_writeMemory(id, address, sizeof(descriptorData), descriptorData, 1) != 0)
+			return -1;
+
+		/**
+		 * write DMA descriptor address to DMA0CFG
+		 */
+		descriptorAddress[0] = address & 0xff;
+		descriptorAddress[1] = (address >> 8) & 0xff;
+
+		if(ccdbg_writeMemory(id, REG_DMA0CFGL, 2, descriptorAddress, 1) != 0)
+			return -1;
+
+		/**
+		 * arm DMA0 for DBGDATA to SRAM data transfer
+		 */
+		if(ccdbg_writeMemory(id, REG_DMAARM, 1, &dmaarmValue, 1) != 0)
+			return -1;
+
+		/**
+		 * write data to SRAM via DBGDATA, at most one burst's worth at a time
+		 */
+		for(bytes = 0; bytes < length; bytes += burstSize)
+		{
+			burstSize = ((length - bytes) > MAXIMUM_BURST_SIZE) ? MAXIMUM_BURST_SIZE : (length - bytes);
+
+			if(issueCommand(CCDBG_COMMAND_BURST_WRITE, burstSize, &data[bytes], 0, 0, ccdbg_retries) < 0)
+				return -1;
+		}
+
+		/**
+		 * DMA0 disarms itself once all of length has been transferred
+		 */
+		if((value = ccdbg_readMemory(id, REG_DMAARM, 0, 0)) < 0 || (value & dmaarmValue))
+			return -1;
+
+		if(verify)
+		{
+			operation.type = CCDBG_MEMORY_COMPARE;
+			operation.address = address;
+			operation.size = length;
+			operation.data = (unsigned char *)data;
+
+			if(ccdbg_executeMemoryOperations(id, 1, &operation, 0) != 0)
+				return -1;
+		}
+
+		address += length;
+		data += length;
+		size -= length;
+	}
+
+	return 0;
+}
+
+int ccdbg_halt(CCDBG_ID id)
+{
+	int value;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if((value = issueCommand(CCDBG_COMMAND_HALT, 0, 0, 0, 0, ccdbg_retries)) < 0)
+		return -1;
+
+	if(!(value & CCDBG_STATUS_CPU_HALTED))
+		return -1;
+
+	if(!context.active)
+		beginContext();
+
+	return 0;
+}
+
+int ccdbg_isHalted(CCDBG_ID id)
+{
+	int value;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if((value = issueCommand(CCDBG_COMMAND_READ_STATUS, 0, 0, 0, 0, ccdbg_retries)) < 0)
+		return -1;
+
+	if(!(value & CCDBG_STATUS_CPU_HALTED))
+		return 0;
+
+	if(!context.active)
+		beginContext();
+
+	return 1;
+}
+
+int ccdbg_waitForHalt(CCDBG_ID id, unsigned int timeout, unsigned int *latency)
+{
+	unsigned long long startTime = ccdbgDevice_getMicroseconds();
+	unsigned long long pollTime = startTime;
+	unsigned long long now;
+	unsigned int interval = MINIMUM_HALT_POLL_INTERVAL;
+	int result;
+
+	/**
+	 * a halt that comes quickly, like after a short step, is caught early,
+	 *   while a long wait settles down to a poll every 10 ms
+	 */
+	while((result = ccdbg_isHalted(id)) == 0)
+	{
+		now = ccdbgDevice_getMicroseconds();
+
+		if(timeout > 0 && now - startTime >= timeout)
+			return 0;
+
+		if(timeout > 0 && now + interval - startTime > timeout)
+			ccdbgDevice_sleep(startTime + timeout - now);
+		else
+			ccdbgDevice_sleep(interval);
+
+		pollTime = now;
+
+		if((interval *= 2) > MAXIMUM_HALT_POLL_INTERVAL)
+			interval = MAXIMUM_HALT_POLL_INTERVAL;
+	}
+
+	if(result > 0 && latency != 0)
+		*latency = (unsigned int)(ccdbgDevice_getMicroseconds() - pollTime);
+
+	return result;
+}
+
+int ccdbg_resume(CCDBG_ID id)
+{
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if(endContext() != 0)
+		return -1;
+
+	/**
+	 * the running CPU changes whatever has been cached
+	 */
+	ccdbg_invalidateCache();
+
+	if(issueCommand(CCDBG_COMMAND_RESUME, 0, 0, 0, 0, ccdbg_retries) < 0)
+		return -1;
+
+	return 0;
+}
+
+int ccdbg_setBreakpoint(CCDBG_ID id, unsigned int number, unsigned int address, int enable)
+{
+	unsigned char inputData[] = {
+			(unsigned char)(((number & 0x3) << 3) | (enable ? 0x04 : 0x00) | ((address >> 16) & 0x3)),	// number, enable, and bank
+			(unsigned char)((address >> 8) & 0xff),
+			(unsigned char)(address & 0xff)
+	};
+
+	if(id == CCDBG_INVALID_ID || id->isLocked || number >= CCDBG_NUMBER_OF_BREAKPOINTS)
+		return -1;
+
+	if(issueCommand(CCDBG_COMMAND_SET_HW_BRKPNT, sizeof(inputData), inputData, 0, 0, ccdbg_retries) < 0)
+		return -1;
+
+	return 0;
+}
+
+static int readPc(void)
+{
+	unsigned short outputData;
+
+	if(issueCommand(CCDBG_COMMAND_GET_PC, 0, 0, 0, &outputData, ccdbg_retries) < 0)
+		return -1;
+
+	/**
+	 * PCH comes first
+	 */
+	return (((unsigned char *)&outputData)[0] << 8) | ((unsigned char *)&outputData)[1];
+}
+
+int ccdbg_getPc(CCDBG_ID id)
+{
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	return readPc();
+}
+
+int ccdbg_stepInstruction(CCDBG_ID id)
+{
+	int pc;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if(endContext() != 0)
+		return -1;
+
+	if(issueCommand(CCDBG_COMMAND_STEP_INSTR, 0, 0, 0, 0, ccdbg_retries) < 0)
+		return -1;
+
+	beginContext();
+
+	if((pc = readPc()) < 0)
+		return -1;
+
+	return pc;
+}
+
+int ccdbg_traceInstructions(CCDBG_ID id, unsigned int count, unsigned int startAddress, unsigned int endAddress, unsigned short *pcs)
+{
+	int pc;
+	unsigned int i;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked || pcs == 0)
+		return -1;
+
+	if(endContext() != 0)
+		return -1;
+
+	/**
+	 * stepped instructions change whatever has been cached; forgetting it
+	 *   once up front leaves the loop with nothing but the two commands
+	 */
+	beginContext();
+
+	for(i = 0; i < count; i++)
+	{
+		if(issueCommand(CCDBG_COMMAND_STEP_INSTR, 0, 0, 0, 0, ccdbg_retries) < 0 || (pc = readPc()) < 0)
+			return ~i;
+
+		pcs[i] = (unsigned short)pc;
+
+		if((unsigned int)pc < startAddress || (unsigned int)pc >= endAddress)
+			return i + 1;
+	}
+
+	return count;
+}
+
+int ccdbg_samplePc(CCDBG_ID id)
+{
+	int pc;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	/**
+	 * nothing but GET_PC between HALT and RESUME
+	 */
+	if(issueCommand(CCDBG_COMMAND_HALT, 0, 0, 0, 0, ccdbg_retries) < 0)
+		return -1;
+
+	pc = readPc();
+
+	if(ccdbg_resume(id) != 0)
+		return -1;
+
+	return pc;
+}
+
+int ccdbg_sampleMemory(CCDBG_ID id, unsigned int count, const CCDBG_MEMORY_OPERATION *operations)
+{
+	int result;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if(ccdbg_halt(id) != 0)
+		return -1;
+
+	result = ccdbg_executeMemoryOperations(id, count, operations, 0);
+
+	if(ccdbg_resume(id) != 0)
+		return -1;
+
+	return result;
+}
+
+int ccdbg_drainLog(CCDBG_ID id, unsigned int address, unsigned int maximumSize, unsigned char *data)
+{
+	CCDBG_MEMORY_OPERATION operations[3];
+	unsigned char header[CCDBG_LOG_HEADER_SIZE];
+	unsigned char tailData[2];
+	unsigned int numberOfOperations = 0;
+	unsigned int size;
+	unsigned int head;
+	unsigned int tail;
+	unsigned int bytes;
+	unsigned int length;
+	int result = -1;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked || data == 0)
+		return -1;
+
+	if(ccdbg_halt(id) != 0)
+		return -1;
+
+	do
+	{
+		if(ccdbg_readMemory(id, address, sizeof(header), header) < 0)
+			break;
+
+		size = header[0] | (header[1] << 8);
+		head = header[2] | (header[3] << 8);
+		tail = header[4] | (header[5] << 8);
+		result = 0;
+
+		if(size == 0 || head >= size || tail >= size)
+			break;
+
+		if((bytes = (head + size - tail) % size) > maximumSize)
+			bytes = maximumSize;
+
+		if(bytes == 0)
+			break;
+
+		/**
+		 * the new bytes, in two parts if they wrap around, and then the
+		 *   tail, in one batch; DPTR is left at the data area by the header
+		 */
+		length = (bytes < size - tail) ? bytes : (size - tail);
+
+		operations[numberOfOperations].type = CCDBG_MEMORY_READ;
+		operations[numberOfOperations].address = address + CCDBG_LOG_HEADER_SIZE + tail;
+		operations[numberOfOperations].size = length;
+		operations[numberOfOperations].data = data;
+		++numberOfOperations;
+
+		if(length < bytes)
+		{
+			operations[numberOfOperations].type = CCDBG_MEMORY_READ;
+			operations[numberOfOperations].address = address + CCDBG_LOG_HEADER_SIZE;
+			operations[numberOfOperations].size = bytes - length;
+			operations[numberOfOperations].data = data + length;
+			++numberOfOperations;
+		}
+
+		tail = (tail + bytes) % size;
+		tailData[0] = tail & 0xff;
+		tailData[1] = (tail >> 8) & 0xff;
+
+		operations[numberOfOperations].type = CCDBG_MEMORY_WRITE;
+		operations[numberOfOperations].address = address + 4;
+		operations[numberOfOperations].size = sizeof(tailData);
+		operations[numberOfOperations].data = tailData;
+		++numberOfOperations;
+
+		result = (ccdbg_executeMemoryOperations(id, numberOfOperations, operations, 0) == 0) ? (int)bytes : -1;
+	}
+	while(0);
+
+	if(ccdbg_resume(id) != 0)
+		return -1;
 
-	/**
-	 * verify the returned chip version
-	 */
-	if(ccdbg_readMemory(id, REG_CHVER, 0, 0) != (unsigned int)id->rev)
-		return CCDBG_INVALID_ID;
+	return result;
+}
 
-	/**
-	 * get the size of the chip's flash memory
-	 */
-	if((value = ccdbg_readMemory(id, REG_CHIPINFO0, 0, 0)) < 0)
-		return CCDBG_INVALID_ID;
+int ccdbg_runFromSram(CCDBG_ID id, unsigned int address)
+{
+	unsigned char instruction[] = { 0x02, (unsigned char)((address >> 8) & 0xff), (unsigned char)(address & 0xff) };
+	unsigned char memctrValue;
+	int value;
 
-	value >>= 4;
-	id->flashSize = (id->id == CCDBG_CHIP_ID_CC2533 && value == 0x3) ? KB(96) : (KB(16) << value);
-	id->writableFlashSize = id->flashSize - FLASH_PAGE_LOCK_BITS_SIZE;
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
 
-	/**
-	 * get the bank size and page size of the chip's flash memory
-	 */
-	id->flashBankSize = KB(32);
-	id->flashPageSize = chip[i].flashPageSize;
+	if(address < (CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - id->sramSize) || address >= (CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - CCDBG_SRAM_IDATA_SIZE))
+		return -1;
 
 	/**
-	 * compute number of flash pages
+	 * map SRAM into CODE via MEMCTR.XMAP
 	 */
-	id->numberOfFlashPages = (id->flashSize + (id->flashPageSize - 1)) / id->flashPageSize;
+	if((value = ccdbg_readMemory(id, REG_MEMCTR, 0, 0)) < 0)
+		return -1;
 
-	/**
-	 * get the size of the chip's SRAM
-	 */
-	if((value = ccdbg_readMemory(id, REG_CHIPINFO1, 0, 0)) < 0)
-		return CCDBG_INVALID_ID;
+	memctrValue = (unsigned char)value | MEMCTR_XMAP;
 
-	id->sramSize = KB(((value & 0x7) + 1));
+	if(ccdbg_writeMemory(id, REG_MEMCTR, 1, &memctrValue, 1) != 0)
+		return -1;
 
 	/**
-	 * if applicable, get the chip's IEEE address
+	 * LJMP addr16
+	 *   addr16 is address
 	 */
-	switch(id->id)
-	{
-	case CCDBG_CHIP_ID_CC2530:
-	case CCDBG_CHIP_ID_CC2531:
-	case CCDBG_CHIP_ID_CC2533:
-		id->ieeeAddressLength = 8;
-		value = 0x780c;
-		break;
+	if(emitInstruction(sizeof(instruction), instruction) < 0)
+		return -1;
 
-	case CCDBG_CHIP_ID_CC2540:
-	case CCDBG_CHIP_ID_CC2541:
-		id->ieeeAddressLength = 6;
-		value = 0x780e;
-		break;
+	return ccdbg_resume(id);
+}
 
-	default:
-		id->ieeeAddressLength = 0;
-		break;
-	}
+static int getSfrSideEffects(unsigned int sfr)
+{
+	unsigned int i;
 
-	if(id->ieeeAddressLength > 0)
+	for(i = 0; i < sizeof(sfrSideEffects) / sizeof(sfrSideEffects[0]); i++)
 	{
-		if(ccdbg_readMemory(id, (unsigned int)value, id->ieeeAddressLength, id->ieeeAddress) < 0)
-			return CCDBG_INVALID_ID;
+		if(sfrSideEffects[i].sfr == sfr)
+			return sfrSideEffects[i].sideEffects;
 	}
 
-	return id;
-}
-
-int ccdbg_executeInstruction(CCDBG_ID id, unsigned int size, const unsigned char *instruction)
-{
-	return executeInstruction(size, instruction);
+	return 0;
 }
 
-int ccdbg_readMemory(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
+int ccdbg_takeSnapshot(CCDBG_ID id, CCDBG_SNAPSHOT *snapshot)
 {
-	unsigned char instruction1[] = { 0x90, (address >> 8) & 0xff, address & 0xff };
-	static unsigned char instruction2 = 0xe0;
-	static unsigned char instruction3 = 0xa3;
-	unsigned char _data;
-	int value;
-	unsigned int i;
-
-	switch(size)
-	{
-	case 0:
-		size = 1;
-		data = &_data;
-		break;
-
-	case 1:
-		if(data == 0)
-			data = &_data;
+	CCDBG_MEMORY_OPERATION operations[sizeof(sfrSideEffects) / sizeof(sfrSideEffects[0]) + 1];
+	unsigned int numberOfOperations = 0;
+	unsigned int sfr;
+	int pc;
 
-		break;
+	if(id == CCDBG_INVALID_ID || id->isLocked || snapshot == 0 || id->sramSize > CCDBG_MAXIMUM_SRAM_SIZE)
+		return -1;
 
-	default:
-		if(data == 0)
-			return -1;
+	if(ccdbg_halt(id) != 0 || (pc = readPc()) < 0)
+		return -1;
 
-		break;
-	}
+	snapshot->pc = pc;
+	snapshot->sramSize = id->sramSize;
+	memset(snapshot->sfr, 0, sizeof(snapshot->sfr));
 
 	/**
-	 * MOV DPTR,#data16
-	 *   #data16 is address
+	 * one read for every run of SFRs that can be read safely
 	 */
-	if(executeInstruction(3, instruction1) < 0)
-		return -1;
-
-	for(i = 0; ; )
+	for(sfr = 0x80; sfr < 0x100; sfr++)
 	{
-		/**
-		 * MOVX A,@DPTR
-		 */
-		if((value = executeInstruction(1, &instruction2)) < 0)
-			return -1;
+		if((getSfrSideEffects(sfr) & SIDE_EFFECT_READ))
+			continue;
 
-		data[i] = value;
-
-		if(++i == size)
-			break;
+		if(numberOfOperations > 0 && operations[numberOfOperations - 1].address + operations[numberOfOperations - 1].size == SFR_WINDOW_START + (sfr - 0x80))
+		{
+			++operations[numberOfOperations - 1].size;
+			continue;
+		}
 
-		/**
-		 * INC DPTR
-		 */
-		if(executeInstruction(1, &instruction3) < 0)
-			return -1;
+		operations[numberOfOperations].type = CCDBG_MEMORY_READ;
+		operations[numberOfOperations].address = SFR_WINDOW_START + (sfr - 0x80);
+		operations[numberOfOperations].size = 1;
+		operations[numberOfOperations].data = &snapshot->sfr[sfr - 0x80];
+		operations[numberOfOperations].sourceAddress = 0;
+		++numberOfOperations;
 	}
 
-	return data[0];
+	if(ccdbg_executeMemoryOperations(id, numberOfOperations, operations, 0) != 0)
+		return -1;
+
+	if(ccdbg_readMemory(id, CCDBG_SRAM_END - id->sramSize, id->sramSize, snapshot->sram) < 0)
+		return -1;
+
+	return 0;
 }
 
-int ccdbg_writeMemory(CCDBG_ID id, unsigned int address, unsigned int size, const unsigned char *data, int verify)
+int ccdbg_restoreSnapshot(CCDBG_ID id, const CCDBG_SNAPSHOT *snapshot)
 {
-	unsigned char instruction1[] = { 0x90, (address >> 8) & 0xff, address & 0xff };
-	unsigned char instruction2[] = { 0x74, 0x00 };
-	static unsigned char instruction3 = 0xf0;
-	static unsigned char instruction4 = 0xa3;
-	unsigned int i;
+	unsigned char instruction[] = { 0x02, (unsigned char)((snapshot->pc >> 8) & 0xff), (unsigned char)(snapshot->pc & 0xff) };
+	unsigned int sfr;
+	unsigned int start;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked || snapshot == 0 || snapshot->sramSize != id->sramSize)
+		return -1;
+
+	if(ccdbg_halt(id) != 0)
+		return -1;
 
 	/**
-	 * MOV DPTR,#data16
-	 *   #data16 is address
+	 * SRAM first, as burst writes go through DMA channel 0 and its SFRs;
+	 *   all of it is verified, since the DMA descriptors are written into
+	 *   the very SRAM being restored
 	 */
-	if(executeInstruction(3, instruction1) < 0)
+	if(ccdbg_burstWriteMemory(id, CCDBG_SRAM_END - id->sramSize, id->sramSize, snapshot->sram, 1) != 0)
 		return -1;
 
-	for(i = 0; ; )
+	for(sfr = start = 0x80; sfr <= 0x100; sfr++)
 	{
-		/**
-		 * MOV A,#data
-		 *   #data is value
-		 */
-		instruction2[1] = data[i];
-
-		if(executeInstruction(2, instruction2) < 0)
-			return -1;
+		if(sfr < 0x100 && !(getSfrSideEffects(sfr) & (SIDE_EFFECT_READ | SIDE_EFFECT_WRITE)))
+			continue;
 
-		/**
-		 * MOVX @DPTR,A
-		 */
-		if(executeInstruction(1, &instruction3) < 0)
+		if(sfr > start && ccdbg_writeMemory(id, SFR_WINDOW_START + (start - 0x80), sfr - start, &snapshot->sfr[start - 0x80], 0) != 0)
 			return -1;
 
-		if(++i == size)
-			break;
-
-		/**
-		 * INC DPTR
-		 */
-		if(executeInstruction(1, &instruction4) < 0)
-			return -1;
+		start = sfr + 1;
 	}
 
 	/**
-	 * verify
+	 * LJMP addr16
+	 *   addr16 is the snapshot's program counter
 	 */
-	if(verify)
-	{
-		for(i = 0; i < size; i++)
-		{
-			if(ccdbg_readMemory(id, address, 0, 0) != data[i])
-				return -1;
-
-			++address;
-		}
-	}
+	if(emitInstruction(sizeof(instruction), instruction) < 0)
+		return -1;
 
 	return 0;
 }
 
-static unsigned int readFlash(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
+static unsigned int readFlashMemory(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
 {
 	unsigned int bytes = 0;
 	unsigned char bank;
@@ -472,7 +1864,7 @@ static unsigned int readFlash(CCDBG_ID id, unsigned int address, unsigned int si
 		 */
 		bank = (unsigned char)(address / id->flashBankSize);
 
-		if(ccdbg_writeMemory(id, REG_MEMCTR, 1, &bank, 1) < 0)
+		if(selectFlashBank(id, bank) < 0)
 			break;
 
 		/**
@@ -499,9 +1891,53 @@ static unsigned int readFlash(CCDBG_ID id, unsigned int address, unsigned int si
 	return (bytes == size) ? bytes : ~bytes;
 }
 
+static unsigned int readFlash(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
+{
+	unsigned int bytes = 0;
+	unsigned int page;
+	unsigned int offset;
+	unsigned int pageSize;
+	unsigned char *cachedData;
+
+	while(bytes < size)
+	{
+		page = address / id->flashPageSize;
+		offset = address % id->flashPageSize;
+		pageSize = id->flashPageSize - offset;
+
+		if((bytes + pageSize) > size)
+			pageSize = size - bytes;
+
+		if((cachedData = findCachedFlashPage(page)) != 0)
+			memcpy(&data[bytes], &cachedData[offset], pageSize);
+		else if(pageSize == id->flashPageSize)
+		{
+			/**
+			 * whole page is read anyway so keep a copy of it
+			 */
+			cachedData = allocateCachedFlashPage(page);
+
+			if(readFlashMemory(id, address, pageSize, cachedData) != pageSize)
+			{
+				uncacheFlashPage(page);
+				break;
+			}
+
+			memcpy(&data[bytes], cachedData, pageSize);
+		}
+		else if(readFlashMemory(id, address, pageSize, &data[bytes]) != pageSize)
+			break;
+
+		bytes += pageSize;
+		address += pageSize;
+	}
+
+	return (bytes == size) ? bytes : ~bytes;
+}
+
 static int writeFlashPage(CCDBG_ID id, unsigned int page, const unsigned char *data, int eraseFirst)
 {
-	unsigned char size[2] = { (id->flashPageSize >> 8) & 0xff, id->flashPageSize & 0xff };
+	unsigned char size[2] = { (unsigned char)((id->flashPageSize >> 8) & 0xff), (unsigned char)(id->flashPageSize & 0xff) };
 
 	unsigned char descriptorData[] = {
 			// source descriptor
@@ -545,17 +1981,17 @@ static int writeFlashPage(CCDBG_ID id, unsigned int page, const unsigned char *d
 	}
 
 	/**
-	 * enable DMA transfers via the debug configuration register
+	 * the lock bits live in the last page
 	 */
-	if((value = ccdbg_command(CCDBG_COMMAND_RD_CONFIG, 0, 0, 0, 0, ccdbg_retries)) < 0)
-		return -1;
-
-	value &= ~CCDBG_CONFIG_DMA_PAUSED;
+	if(page == id->numberOfFlashPages - 1)
+		state.valid &= ~STATE_LOCK_BITS;
 
-	if((value = ccdbg_command(CCDBG_COMMAND_WR_CONFIG, 1, (unsigned char *)&value, 0, 0, ccdbg_retries)) < 0)
-		return -1;
+	uncacheFlashPage(page);
 
-	if((value & (CCDBG_STATUS_CHIP_ERASE_BUSY | CCDBG_STATUS_PCON_IDLE | CCDBG_STATUS_PM_ACTIVE | CCDBG_STATUS_DEBUG_LOCKED)))
+	/**
+	 * enable DMA transfers via the debug configuration register
+	 */
+	if(enableDma(id) != 0)
 		return -1;
 
 	/**
@@ -589,7 +2025,7 @@ static int writeFlashPage(CCDBG_ID id, unsigned int page, const unsigned char *d
 	/**
 	 * write flash data to SRAM via DBGDATA
 	 */
-	if(ccdbg_command(CCDBG_COMMAND_BURST_WRITE, id->flashPageSize, data, 0, 0, ccdbg_retries) < 0)
+	if(issueCommand(CCDBG_COMMAND_BURST_WRITE, id->flashPageSize, data, 0, 0, ccdbg_retries) < 0)
 		return -1;
 
 	/**
@@ -688,9 +2124,12 @@ static unsigned int writeFlash(CCDBG_ID id, unsigned int address, unsigned int s
 
 			if(verify)
 			{
+				/**
+				 * read back from the chip itself, never from the page cache
+				 */
 				for(i = 2; i > 0; i--)
 				{
-					if(readFlash(id, pageAddress, id->flashPageSize, readBuffer) != id->flashPageSize)
+					if(readFlashMemory(id, pageAddress, id->flashPageSize, readBuffer) != id->flashPageSize)
 						break;
 
 					for(j = 0; j < id->flashPageSize && readBuffer[j] == writeData[j]; j++);
@@ -702,6 +2141,8 @@ static unsigned int writeFlash(CCDBG_ID id, unsigned int address, unsigned int s
 				if(i < 1)
 					break;
 			}
+
+			memcpy(allocateCachedFlashPage(page), writeData, id->flashPageSize);
 		}
 
 		address += dataBytes;
@@ -713,20 +2154,30 @@ static unsigned int writeFlash(CCDBG_ID id, unsigned int address, unsigned int s
 	return (bytes == size) ? bytes : ~bytes;
 }
 
-int ccdbg_isFlashPageLocked(CCDBG_ID id, unsigned int page)
+static int readLockBits(CCDBG_ID id)
 {
-	unsigned char lockBits;
+	if((state.valid & STATE_LOCK_BITS))
+		return 0;
+
+	if(readFlash(id, id->writableFlashSize, FLASH_PAGE_LOCK_BITS_SIZE, state.lockBits) != FLASH_PAGE_LOCK_BITS_SIZE)
+		return -1;
+
+	state.valid |= STATE_LOCK_BITS;
+	return 0;
+}
 
+int ccdbg_isFlashPageLocked(CCDBG_ID id, unsigned int page)
+{
 	if(id == CCDBG_INVALID_ID || id->isLocked)
 		return -1;
 
 	if(page >= id->numberOfFlashPages)
 		return -1;
 
-	if(readFlash(id, id->writableFlashSize + (page / 8), 1, &lockBits) != 1)
+	if(readLockBits(id) != 0)
 		return -1;
 
-	return !(lockBits & (0x1 << (page % 8)));
+	return !(state.lockBits[page / 8] & (0x1 << (page % 8)));
 }
 
 static int lockUnlockFlashPages(CCDBG_ID id, int lock, unsigned int startPage, unsigned int numberOfPages)
@@ -742,9 +2193,11 @@ static int lockUnlockFlashPages(CCDBG_ID id, int lock, unsigned int startPage, u
 	if(startPage >= id->numberOfFlashPages)
 		return -1;
 
-	if(readFlash(id, id->writableFlashSize, FLASH_PAGE_LOCK_BITS_SIZE, lockBits) != FLASH_PAGE_LOCK_BITS_SIZE)
+	if(readLockBits(id) != 0)
 		return -1;
 
+	memcpy(lockBits, state.lockBits, FLASH_PAGE_LOCK_BITS_SIZE);
+
 	if((startPage + numberOfPages) > id->numberOfFlashPages)
 		numberOfPages = id->numberOfFlashPages - startPage;
 
@@ -768,8 +2221,14 @@ static int lockUnlockFlashPages(CCDBG_ID id, int lock, unsigned int startPage, u
 		}
 	}
 
-	if(changed && writeFlash(id, id->writableFlashSize, FLASH_PAGE_LOCK_BITS_SIZE, lockBits, 1, 0) != FLASH_PAGE_LOCK_BITS_SIZE)
-		return -1;
+	if(changed)
+	{
+		if(writeFlash(id, id->writableFlashSize, FLASH_PAGE_LOCK_BITS_SIZE, lockBits, 1, 0) != FLASH_PAGE_LOCK_BITS_SIZE)
+			return -1;
+
+		memcpy(state.lockBits, lockBits, FLASH_PAGE_LOCK_BITS_SIZE);
+		state.valid |= STATE_LOCK_BITS;
+	}
 
 	return 0;
 }
@@ -826,6 +2285,11 @@ int ccdbg_eraseFlashPage(CCDBG_ID id, unsigned int page)
 	if(id->id != CCDBG_CHIP_ID_CC2533)
 		value <<= 1;
 
+	if(page == id->numberOfFlashPages - 1)
+		state.valid &= ~STATE_LOCK_BITS;
+
+	uncacheFlashPage(page);
+
 	if(ccdbg_writeMemory(id, REG_FADDRH, 1, &value, 1) < 0)
 		return -1;
 
@@ -842,9 +2306,110 @@ int ccdbg_eraseFlashPage(CCDBG_ID id, unsigned int page)
 	if((value & (FCTL_ERASE | FCTL_WRITE | FCTL_ABORT | FCTL_FULL)))
 		return -1;
 
+	memset(allocateCachedFlashPage(page), 0xff, id->flashPageSize);
 	return 0;
 }
 
+int ccdbg_getFlashPageCrc(CCDBG_ID id, unsigned int page)
+{
+	unsigned int address;
+	unsigned char bank;
+	unsigned char crc[2];
+	unsigned char savedData[8];
+	unsigned long long startTime;
+
+	unsigned char descriptorData[] = {
+			0x00, 0x00,			// source: flash page in the XBANK window
+			0x70, 0xbd,			// destination: RNDH (0x70bd)
+			0x00, 0x00,			// length: flash page size
+			0x20,				// transfer mode: block, trigger: none (DMAREQ)
+			0x42				// source increment: 1, destination increment: 0, priority: high
+	};
+
+	static unsigned char descriptorAddress[] = { 0x00, 0x00 };	// DMA0 descriptor address: 0x0000
+	static unsigned char seed = 0xff;
+	static unsigned char dmaValue = 0x01;						// arm and trigger DMA0
+	static unsigned char dmaAbortValue = 0x81;					// abort DMA0
+	int value = -1;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	if(page >= id->numberOfFlashPages)
+		return -1;
+
+	address = page * id->flashPageSize;
+	bank = (unsigned char)(address / id->flashBankSize);
+	address = REG_XDATA + (address % id->flashBankSize);
+
+	descriptorData[0] = (address >> 8) & 0xff;
+	descriptorData[1] = address & 0xff;
+	descriptorData[4] = (id->flashPageSize >> 8) & 0x1f;
+	descriptorData[5] = id->flashPageSize & 0xff;
+
+	/**
+	 * map the flash page into XDATA, where DMA can read it
+	 */
+	if(selectFlashBank(id, bank) < 0)
+		return -1;
+
+	if(enableDma(id) != 0)
+		return -1;
+
+	/**
+	 * the descriptor borrows SRAM at 0x0000, which is given back afterwards
+	 */
+	if(ccdbg_readMemory(id, 0x0000, sizeof(savedData), savedData) < 0)
+		return -1;
+
+	do
+	{
+		if(ccdbg_writeMemory(id, 0x0000, sizeof(descriptorData), descriptorData, 1) < 0)
+			break;
+
+		if(ccdbg_writeMemory(id, REG_DMA0CFGL, 2, descriptorAddress, 1) < 0)
+			break;
+
+		/**
+		 * seed the CRC with two writes to RNDL
+		 */
+		if(ccdbg_writeMemory(id, REG_RNDL, 1, &seed, 0) < 0 || ccdbg_writeMemory(id, REG_RNDL, 1, &seed, 0) < 0)
+			break;
+
+		/**
+		 * feed the page to RNDH with a single block transfer
+		 */
+		if(ccdbg_writeMemory(id, REG_DMAARM, 1, &dmaValue, 0) < 0)
+			break;
+
+		if(ccdbg_writeMemory(id, REG_DMAREQ, 1, &dmaValue, 0) < 0)
+			break;
+
+		startTime = ccdbgDevice_getMicroseconds();
+
+		while((value = ccdbg_readMemory(id, REG_DMAARM, 0, 0)) >= 0 && (value & dmaValue))
+		{
+			if(ccdbgDevice_getMicroseconds() - startTime > DMA_TIMEOUT)
+			{
+				ccdbg_writeMemory(id, REG_DMAARM, 1, &dmaAbortValue, 0);
+				value = -1;
+				break;
+			}
+		}
+
+		if(value < 0 || ccdbg_readMemory(id, REG_RNDL, 2, crc) < 0)
+			value = -1;
+		else
+			value = (crc[1] << 8) | crc[0];
+	}
+	while(0);
+
+	if(ccdbg_writeMemory(id, 0x0000, sizeof(savedData), savedData, 1) < 0)
+		return -1;
+
+	return value;
+}
+
 int ccdbg_readFlash(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data)
 {
 	if(id == CCDBG_INVALID_ID || id->isLocked)
@@ -886,12 +2451,14 @@ int ccdbg_eraseFlash(CCDBG_ID id)
 	if(id == CCDBG_INVALID_ID)
 		return -1;
 
-	if(ccdbg_command(CCDBG_COMMAND_CHIP_ERASE, 0, 0, 0, &status, ccdbg_retries) < 0)
+	ccdbg_invalidateCache();
+
+	if(issueCommand(CCDBG_COMMAND_CHIP_ERASE, 0, 0, 0, &status, ccdbg_retries) < 0)
 		return -1;
 
 	while((status & CCDBG_STATUS_CHIP_ERASE_BUSY))
 	{
-		if(ccdbg_command(CCDBG_COMMAND_READ_STATUS, 0, 0, 0, &status, ccdbg_retries) < 0)
+		if(issueCommand(CCDBG_COMMAND_READ_STATUS, 0, 0, 0, &status, ccdbg_retries) < 0)
 			return -1;
 	}
 
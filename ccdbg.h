@@ -56,6 +56,52 @@ typedef struct {
 
 #define CCDBG_INVALID_ID	(CCDBG_ID)0
 
+/**
+ * SRAM ends at XDATA 0x2000 and, with MEMCTR.XMAP set, also appears in
+ *   CODE at the same offset from 0x8000
+ */
+#define CCDBG_SRAM_END			0x2000
+#define CCDBG_SRAM_CODE_OFFSET	0x8000
+
+/**
+ * the last 0x100 bytes of SRAM mirror IDATA, which holds the registers and
+ *   the stack of running code, so code is not loaded or run there
+ */
+#define CCDBG_SRAM_IDATA_SIZE	0x100
+
+#define CCDBG_NUMBER_OF_BREAKPOINTS	4
+
+#define CCDBG_MAXIMUM_SRAM_SIZE		0x2000
+#define CCDBG_NUMBER_OF_SFRS		0x80
+
+/**
+ * state of the halted CPU; the CPU registers ACC, B, PSW, SP, DPS, DPTR,
+ *   and DPTR1 are SFRs, and R0 ~ R7 of all register banks are at the
+ *   bottom of IDATA, which is the top 256 bytes of SRAM
+ */
+typedef struct {
+	unsigned int pc;
+	unsigned int sramSize;
+	unsigned char sfr[CCDBG_NUMBER_OF_SFRS];	/* SFRs 0x80 ~ 0xff; 0 for those with side effects on reading */
+	unsigned char sram[CCDBG_MAXIMUM_SRAM_SIZE];	/* XDATA (CCDBG_SRAM_END - sramSize) ~ (CCDBG_SRAM_END - 1) */
+} CCDBG_SNAPSHOT;
+
+/**
+ * target log channel; a ring buffer in XDATA that the firmware writes text
+ *   into and the host drains (little-endian 16-bit fields):
+ *
+ *   +0	size - size of the data area
+ *   +2	head - data offset of the next byte the firmware writes, advanced
+ *         by the firmware only
+ *   +4	tail - data offset of the next byte the host reads, advanced by
+ *         the host only
+ *   +6	data - size bytes
+ *
+ * the buffer is empty when head equals tail and full when head is one byte
+ *   behind tail; the firmware drops or waits on what does not fit
+ */
+#define CCDBG_LOG_HEADER_SIZE	6
+
 typedef enum {
 	CCDBG_COMMAND_CHIP_ERASE		= 0x02,
 	CCDBG_COMMAND_WR_CONFIG			= 0x03,
@@ -90,6 +136,26 @@ typedef enum {
 	CCDBG_CONFIG_SOFT_POWER_MODE	= 0x20
 } CCDBG_CONFIG;
 
+typedef enum {
+	CCDBG_MEMORY_READ,		/* read size bytes at address into data */
+	CCDBG_MEMORY_WRITE,		/* write size bytes of data to address */
+	CCDBG_MEMORY_COMPARE,	/* compare size bytes at address against data */
+	CCDBG_MEMORY_COPY		/* copy size bytes from sourceAddress to address */
+} CCDBG_MEMORY_OPERATION_TYPE;
+
+typedef struct {
+	CCDBG_MEMORY_OPERATION_TYPE type;
+	unsigned int address;
+	unsigned int size;
+	unsigned char *data;
+	unsigned int sourceAddress;
+} CCDBG_MEMORY_OPERATION;
+
+typedef struct {
+	unsigned int instructions;			/* debug instructions issued */
+	unsigned int savedInstructions;		/* debug instructions saved against the plain sequence */
+} CCDBG_MEMORY_STATISTICS;
+
 /**
  * default number of retries in reading the chip's response to a command
  */
@@ -113,9 +179,20 @@ void ccdbg_reset(void);
  * returns the chip's response which is the same as the value of
  *   outputData if successful, negative value if no response is
  *   received from the chip
+ *
+ * note: commands that may change the chip's state also discard the
+ *   cached chip state (see ccdbg_invalidateCache)
  */
 int ccdbg_command(CCDBG_COMMAND command, unsigned int inputDataSize, const unsigned char *inputData, unsigned int *outputDataSize, unsigned short *outputData, int retries);
 
+/**
+ * discard the cached chip state (flash bank selection, debug configuration,
+ *   flash page lock bits, and contents of recently read or written flash
+ *   pages); done implicitly on reset, chip erase, CPU resume, and raw debug
+ *   commands or instructions
+ */
+void ccdbg_invalidateCache(void);
+
 /**
  * identify and get the chip's info
  *
@@ -149,6 +226,9 @@ int ccdbg_executeInstruction(CCDBG_ID id, unsigned int size, const unsigned char
  *
  * returns the value of the first byte of data if successful,
  *   a value less than zero for error
+ *
+ * note: SFRs mirrored at 0x7080 ~ 0x70ff are read with direct addressing,
+ *   one instruction per byte
  */
 int ccdbg_readMemory(CCDBG_ID id, unsigned int address, unsigned int size, unsigned char *data);
 
@@ -162,9 +242,239 @@ int ccdbg_readMemory(CCDBG_ID id, unsigned int address, unsigned int size, unsig
  * verify - verify written data or not
  *
  * returns 0 if successful, non-zero otherwise
+ *
+ * note: SFRs mirrored at 0x7080 ~ 0x70ff are written with direct addressing,
+ *   one instruction per byte
  */
 int ccdbg_writeMemory(CCDBG_ID id, unsigned int address, unsigned int size, const unsigned char *data, int verify);
 
+/**
+ * write a block to the chip's SRAM with burst writes through DMA
+ *
+ * id - chip's identification
+ * address - SRAM base address
+ * size - data size
+ * data - source buffer of data
+ * verify - verify written data or not
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: DMA channel 0 is used; blocks that are small or not entirely in
+ *   SRAM are written with ccdbg_writeMemory instead
+ */
+int ccdbg_burstWriteMemory(CCDBG_ID id, unsigned int address, unsigned int size, const unsigned char *data, int verify);
+
+/**
+ * execute a batch of memory operations with as few debug instructions
+ *   as possible
+ *
+ * id - chip's identification
+ * count - number of operations
+ * operations - operations executed in order
+ * statistics - optional; receives number of debug instructions issued and
+ *   saved compared to reloading DPTR for every operation and every
+ *   compared byte, and loading A for every written byte
+ *
+ * returns 0 if successful, non-zero otherwise including a compare
+ *   operation that did not match
+ *
+ * note: both data pointers (DPTR and DPTR1, selected by DPS) and the
+ *   accumulator are tracked across calls; a compare operation that
+ *   directly follows a write operation of the same data is merged into it
+ */
+int ccdbg_executeMemoryOperations(CCDBG_ID id, unsigned int count, const CCDBG_MEMORY_OPERATION *operations, CCDBG_MEMORY_STATISTICS *statistics);
+
+/**
+ * halt the CPU
+ *
+ * id - chip's identification
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: while the CPU is halted, the accumulator and the data pointers
+ *   (DPS, DPTR, and DPTR1) are saved before memory access instructions
+ *   first change them, and restored when the CPU is resumed or stepped;
+ *   values written to them on purpose through memory are kept
+ */
+int ccdbg_halt(CCDBG_ID id);
+
+/**
+ * check if the CPU is halted, e.g. at a breakpoint
+ *
+ * id - chip's identification
+ *
+ * returns 0 if running, greater than zero if halted,
+ *   and less than zero for error
+ *
+ * note: see ccdbg_halt for the registers saved while halted
+ */
+int ccdbg_isHalted(CCDBG_ID id);
+
+/**
+ * wait for the CPU to halt, e.g. at a breakpoint, polling the debug status;
+ *   polls start 100 us apart and back off to 10 ms apart
+ *
+ * id - chip's identification
+ * timeout - microseconds to wait for, 0 to wait for as long as it takes
+ * latency - optional; receives the microseconds between the last poll
+ *   that found the CPU running and the one that found it halted, the most
+ *   the halt can have gone unnoticed
+ *
+ * returns greater than zero if halted, 0 if timed out, and less than zero
+ *   for error
+ *
+ * note: see ccdbg_halt for the registers saved while halted
+ */
+int ccdbg_waitForHalt(CCDBG_ID id, unsigned int timeout, unsigned int *latency);
+
+/**
+ * resume the CPU
+ *
+ * id - chip's identification
+ *
+ * returns 0 if successful, non-zero otherwise
+ */
+int ccdbg_resume(CCDBG_ID id);
+
+/**
+ * step a CPU instruction
+ *
+ * id - chip's identification
+ *
+ * returns the program counter after the instruction if successful,
+ *   a value less than zero for error
+ */
+int ccdbg_stepInstruction(CCDBG_ID id);
+
+/**
+ * set or clear a hardware breakpoint
+ *
+ * id - chip's identification
+ * number - breakpoint, 0 ~ (CCDBG_NUMBER_OF_BREAKPOINTS - 1)
+ * address - code address; bits 17:16 select the flash bank
+ * enable - 0 to clear, non-zero to set
+ *
+ * returns 0 if successful, non-zero otherwise
+ */
+int ccdbg_setBreakpoint(CCDBG_ID id, unsigned int number, unsigned int address, int enable);
+
+/**
+ * get the program counter of the halted CPU
+ *
+ * id - chip's identification
+ *
+ * returns the program counter if successful, a value less than zero for error
+ */
+int ccdbg_getPc(CCDBG_ID id);
+
+/**
+ * step CPU instructions and record the program counter after each one
+ *
+ * id - chip's identification
+ * count - maximum number of instructions to step
+ * startAddress - lowest program counter value to keep stepping at
+ * endAddress - program counter value past the highest one to keep stepping at
+ * pcs - destination buffer of count program counters
+ *
+ * returns the number of instructions stepped if successful,
+ *   a negative value if unsuccessful with its ones' complement
+ *   representing the number of instructions successfully stepped
+ *
+ * note: stepping starts at the current program counter, so the CPU is
+ *   best halted within the range first, e.g. at a breakpoint on
+ *   startAddress; it stops early, after recording it, at the first program
+ *   counter outside startAddress ~ (endAddress - 1)
+ */
+int ccdbg_traceInstructions(CCDBG_ID id, unsigned int count, unsigned int startAddress, unsigned int endAddress, unsigned short *pcs);
+
+/**
+ * sample the program counter of the running CPU; the CPU is halted only
+ *   for as long as it takes to read the program counter
+ *
+ * id - chip's identification
+ *
+ * returns the program counter if successful, a value less than zero for error
+ */
+int ccdbg_samplePc(CCDBG_ID id);
+
+/**
+ * execute a batch of memory operations on the running CPU; the CPU is
+ *   halted only for as long as it takes to execute them
+ *
+ * id - chip's identification
+ * count - number of operations
+ * operations - operations executed in order
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: see ccdbg_executeMemoryOperations; reads sorted by address make
+ *   the most of the tracked data pointers
+ */
+int ccdbg_sampleMemory(CCDBG_ID id, unsigned int count, const CCDBG_MEMORY_OPERATION *operations);
+
+/**
+ * drain new bytes from a target log channel (see CCDBG_LOG_HEADER_SIZE);
+ *   the CPU is halted only for as long as it takes to read the header and
+ *   the new bytes and to advance the tail
+ *
+ * id - chip's identification
+ * address - XDATA address of the log channel header
+ * maximumSize - maximum number of bytes to drain
+ * data - destination buffer of maximumSize bytes
+ *
+ * returns the number of bytes drained if successful, a value less than
+ *   zero for error
+ *
+ * note: a header with a size of 0, or with head or tail out of range, is
+ *   taken as a channel the firmware has yet to set up and nothing is drained
+ */
+int ccdbg_drainLog(CCDBG_ID id, unsigned int address, unsigned int maximumSize, unsigned char *data);
+
+/**
+ * halt the CPU and take a snapshot of its state
+ *
+ * id - chip's identification
+ * snapshot - receives the snapshot
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: the CPU is left halted; SFRs with side effects on reading, like
+ *   the UART and radio FIFOs, are not read, and XREGs (radio, USB, flash
+ *   controller, etc.) are not part of the snapshot
+ */
+int ccdbg_takeSnapshot(CCDBG_ID id, CCDBG_SNAPSHOT *snapshot);
+
+/**
+ * halt the CPU and restore its state from a snapshot
+ *
+ * id - chip's identification
+ * snapshot - snapshot of the same kind of chip
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: the CPU is left halted at the snapshot's program counter; SRAM is
+ *   written with burst writes and verified, then SFRs without side effects
+ *   on writing, like strobe, FIFO, counter, and DMA arming registers, are
+ *   written back
+ */
+int ccdbg_restoreSnapshot(CCDBG_ID id, const CCDBG_SNAPSHOT *snapshot);
+
+/**
+ * run code already loaded into SRAM
+ *
+ * id - chip's identification
+ * address - CODE address of the entry point, within
+ *   (CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - sramSize) ~
+ *   (CCDBG_SRAM_CODE_OFFSET + CCDBG_SRAM_END - CCDBG_SRAM_IDATA_SIZE - 1)
+ *
+ * returns 0 if successful, non-zero otherwise
+ *
+ * note: MEMCTR.XMAP is set, the PC is set with an LJMP instruction, and
+ *   the CPU is resumed; the IDATA mirror at the top of SRAM is excluded
+ *   since the running code's stack and registers would overwrite it
+ */
+int ccdbg_runFromSram(CCDBG_ID id, unsigned int address);
+
 /**
  * check if flash page is locked for writing
  *
@@ -231,6 +541,22 @@ int ccdbg_writeFlashPage(CCDBG_ID id, unsigned int page, const unsigned char *da
  */
 int ccdbg_eraseFlashPage(CCDBG_ID id, unsigned int page);
 
+/**
+ * compute the CRC16 of a chip's flash page on the chip itself, by feeding
+ *   the page to the CRC16 hardware of RNDL and RNDH with DMA
+ *
+ * id - chip's identification
+ * page - flash page
+ *
+ * returns the CRC16 if successful, a negative value otherwise
+ *
+ * note: CRC16 is seeded with 0xffff; it is the same as intelHex_crc16()
+ * note: SRAM at 0x0000 ~ 0x0007 holds the DMA descriptor while the CRC16
+ *   is computed, and is restored afterwards
+ * note: fails if the DMA doesn't finish within 100 ms
+ */
+int ccdbg_getFlashPageCrc(CCDBG_ID id, unsigned int page);
+
 /**
  * read from the chip's flash
  *
@@ -0,0 +1,886 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Billy Millare
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * 18oct2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "gdbserver.h"
+
+#define PREFIX			"gdbserver: "
+
+#ifdef GDBSERVER_VERBOSE
+#define ERROR(...)		fprintf(stderr, PREFIX "error: " __VA_ARGS__)
+#define WARNING(...)	fprintf(stderr, PREFIX "warning: " __VA_ARGS__)
+#else
+#define ERROR(...)
+#define WARNING(...)
+#endif
+
+#define PACKET_SIZE				4096
+#define MAXIMUM_MEMORY_SIZE		((PACKET_SIZE - 4) / 2)
+#define INTERRUPT				0x03
+#define HALT_POLL_INTERVAL		10000	// microseconds
+
+#define CACHE_LINE_SIZE			32
+#define CACHE_LINES				128
+#define READAHEAD_LINES			3
+
+#define NUMBER_OF_REGISTERS		15
+#define REGISTERS_SIZE			(NUMBER_OF_REGISTERS - 1 + 4)
+#define FLASH_BANK_SIZE			0x8000
+
+enum {
+	REG_SP			= 0x7081,
+	REG_DPL0		= 0x7082,
+	REG_DPH0		= 0x7083,
+	REG_FMAP		= 0x709f,
+	REG_MEMCTR		= 0x70c7,
+	REG_PSW			= 0x70d0,
+	REG_ACC			= 0x70e0,
+	REG_B			= 0x70f0,
+	REG_IDATA		= 0x1f00
+};
+
+enum {
+	SIGNAL_INTERRUPT	= 2,
+	SIGNAL_TRAP			= 5
+};
+
+static struct {
+	CCDBG_ID id;
+	int socket;
+	GdbServerStatistics statistics;
+	unsigned char input[PACKET_SIZE];
+	unsigned int inputSize;
+	unsigned int inputPosition;
+	int registersValid;
+	unsigned char registers[REGISTERS_SIZE];
+	int memctr;
+	struct {
+		int enabled;
+		unsigned int address;
+	} breakpoints[CCDBG_NUMBER_OF_BREAKPOINTS];
+} server;
+
+/**
+ * lines of flash and SRAM, valid only while the CPU stays halted; the
+ *   next line to replace goes round-robin
+ */
+static struct {
+	int valid;
+	unsigned int address;
+	unsigned char data[CACHE_LINE_SIZE];
+} cache[CACHE_LINES];
+
+static unsigned int nextCacheLine;
+
+/******************************************************************************
+ * connection
+ */
+
+static int acceptConnection(const char *address)
+{
+	struct sockaddr_in inetAddress;
+	struct sockaddr_un unixAddress;
+	struct stat fileStatus;
+	int listener;
+	int connection;
+	int option = 1;
+	char *end;
+	long port = strtol(address, &end, 10);
+
+	if(*end == '\0')
+	{
+		memset(&inetAddress, 0, sizeof(inetAddress));
+		inetAddress.sin_family = AF_INET;
+		inetAddress.sin_port = htons((unsigned short)port);
+		inetAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if((listener = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+			return -1;
+
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+		if(bind(listener, (struct sockaddr *)&inetAddress, sizeof(inetAddress)) != 0)
+		{
+			ERROR("failed to bind to port %ld\n", port);
+			close(listener);
+			return -1;
+		}
+	}
+	else
+	{
+		if(strlen(address) >= sizeof(unixAddress.sun_path))
+			return -1;
+
+		memset(&unixAddress, 0, sizeof(unixAddress));
+		unixAddress.sun_family = AF_UNIX;
+		strcpy(unixAddress.sun_path, address);
+
+		/**
+		 * only a stale socket is removed; anything else at the path is left alone
+		 */
+		if(lstat(address, &fileStatus) == 0)
+		{
+			if(!S_ISSOCK(fileStatus.st_mode))
+			{
+				ERROR("\"%s\" exists and is not a socket\n", address);
+				return -1;
+			}
+
+			unlink(address);
+		}
+
+		if((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+			return -1;
+
+		if(bind(listener, (struct sockaddr *)&unixAddress, sizeof(unixAddress)) != 0)
+		{
+			ERROR("failed to bind to \"%s\"\n", address);
+			close(listener);
+			return -1;
+		}
+	}
+
+	if(listen(listener, 1) != 0)
+	{
+		close(listener);
+		return -1;
+	}
+
+	connection = accept(listener, NULL, NULL);
+	close(listener);
+
+	if(*end != '\0')
+		unlink(address);
+
+	return connection;
+}
+
+static int receiveByte(void)
+{
+	ssize_t size;
+
+	if(server.inputPosition == server.inputSize)
+	{
+		if((size = recv(server.socket, server.input, sizeof(server.input), 0)) <= 0)
+			return -1;
+
+		server.inputSize = size;
+		server.inputPosition = 0;
+	}
+
+	return server.input[server.inputPosition++];
+}
+
+static int isInputPending(void)
+{
+	struct timeval timeout = { 0, HALT_POLL_INTERVAL };
+	fd_set sockets;
+
+	if(server.inputPosition < server.inputSize)
+		return 1;
+
+	FD_ZERO(&sockets);
+	FD_SET(server.socket, &sockets);
+
+	return (select(server.socket + 1, &sockets, NULL, NULL, &timeout) > 0);
+}
+
+static int hexToValue(int hex)
+{
+	if(hex >= '0' && hex <= '9')
+		return hex - '0';
+
+	if(hex >= 'a' && hex <= 'f')
+		return hex - 'a' + 10;
+
+	if(hex >= 'A' && hex <= 'F')
+		return hex - 'A' + 10;
+
+	return -1;
+}
+
+/**
+ * receives a packet's data, NUL-terminated, and acknowledges it; stray
+ *   bytes, like acknowledgements and interrupts, are dropped
+ */
+static int receivePacket(char *packet)
+{
+	unsigned int size;
+	unsigned char checksum;
+	int byte;
+	int high;
+	int low;
+
+	for(;;)
+	{
+		while((byte = receiveByte()) != '$')
+		{
+			if(byte < 0)
+				return -1;
+		}
+
+		for(size = 0, checksum = 0; (byte = receiveByte()) != '#' && byte >= 0 && size < PACKET_SIZE - 1; size++)
+		{
+			packet[size] = byte;
+			checksum += byte;
+		}
+
+		if(byte != '#' || (high = hexToValue(receiveByte())) < 0 || (low = hexToValue(receiveByte())) < 0)
+			return -1;
+
+		packet[size] = '\0';
+
+		if(((high << 4) | low) == checksum)
+			break;
+
+		WARNING("bad checksum\n");
+
+		if(send(server.socket, "-", 1, 0) != 1)
+			return -1;
+	}
+
+	++server.statistics.packets;
+
+	return (send(server.socket, "+", 1, 0) == 1) ? (int)size : -1;
+}
+
+static int sendPacket(const char *packet)
+{
+	static const char hex[] = "0123456789abcdef";
+	char *frame;
+	unsigned int size = strlen(packet);
+	unsigned char checksum = 0;
+	unsigned int i;
+	int byte;
+	int result = -1;
+
+	if((frame = (char *)malloc(size + 4)) == NULL)
+		return -1;
+
+	frame[0] = '$';
+
+	for(i = 0; i < size; i++)
+	{
+		frame[i + 1] = packet[i];
+		checksum += packet[i];
+	}
+
+	frame[size + 1] = '#';
+	frame[size + 2] = hex[checksum >> 4];
+	frame[size + 3] = hex[checksum & 0xf];
+
+	/**
+	 * resend until acknowledged
+	 */
+	do
+	{
+		if(send(server.socket, frame, size + 4, 0) != (ssize_t)(size + 4))
+			break;
+
+		while((byte = receiveByte()) != '+' && byte != '-' && byte >= 0);
+
+		if(byte == '+')
+			result = 0;
+	}
+	while(byte == '-');
+
+	free(frame);
+	return result;
+}
+
+static void bytesToHex(char *string, const unsigned char *data, unsigned int size)
+{
+	static const char hex[] = "0123456789abcdef";
+	unsigned int i;
+
+	for(i = 0; i < size; i++)
+	{
+		*string++ = hex[data[i] >> 4];
+		*string++ = hex[data[i] & 0xf];
+	}
+
+	*string = '\0';
+}
+
+static int hexToBytes(const char *string, unsigned char *data, unsigned int size)
+{
+	unsigned int i;
+	int high;
+	int low;
+
+	for(i = 0; i < size; i++)
+	{
+		if((high = hexToValue(string[i * 2])) < 0 || (low = hexToValue(string[i * 2 + 1])) < 0)
+			return -1;
+
+		data[i] = (high << 4) | low;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ * memory
+ */
+
+static void invalidateCache(void)
+{
+	unsigned int i;
+
+	for(i = 0; i < CACHE_LINES; i++)
+		cache[i].valid = 0;
+
+	server.registersValid = 0;
+}
+
+/**
+ * end of the region at address that is all cacheable, or all not; 0 if
+ *   address is in neither address space
+ */
+static unsigned int getRegionEnd(unsigned int address, int *isCacheable)
+{
+	unsigned int sramStart = GDBSERVER_XDATA_OFFSET + CCDBG_SRAM_END - server.id->sramSize;
+	unsigned int sramEnd = GDBSERVER_XDATA_OFFSET + CCDBG_SRAM_END;
+	unsigned int end;
+
+	if(address < server.id->flashSize)
+	{
+		*isCacheable = 1;
+		end = server.id->flashSize;
+	}
+	else if(address >= sramStart && address < sramEnd)
+	{
+		*isCacheable = 1;
+		end = sramEnd;
+	}
+	else if(address >= GDBSERVER_XDATA_OFFSET && address < GDBSERVER_XDATA_OFFSET + 0x10000)
+	{
+		*isCacheable = 0;
+		end = (address < sramStart) ? sramStart : (GDBSERVER_XDATA_OFFSET + 0x10000);
+	}
+	else
+		return 0;
+
+	return end;
+}
+
+static int readTarget(unsigned int address, unsigned int size, unsigned char *data)
+{
+	unsigned int length;
+
+	++server.statistics.targetReads;
+
+	if(address >= GDBSERVER_XDATA_OFFSET)
+		return (ccdbg_readMemory(server.id, address - GDBSERVER_XDATA_OFFSET, size, data) < 0) ? -1 : 0;
+
+	/**
+	 * flash is read through the XDATA window that MEMCTR maps; keep the
+	 *   firmware's setting to put back before it runs again
+	 */
+	if(server.memctr < 0 && (server.memctr = ccdbg_readMemory(server.id, REG_MEMCTR, 0, 0)) < 0)
+		return -1;
+
+	if(address > server.id->flashSize || size > (server.id->flashSize - address))
+		return -1;
+
+	length = (address >= server.id->writableFlashSize) ? 0 : (server.id->writableFlashSize - address);
+
+	if(length > size)
+		length = size;
+
+	if(length > 0 && ccdbg_readFlash(server.id, address, length, data) != (int)length)
+		return -1;
+
+	/**
+	 * the lock bits past the writable flash are not read as memory, and
+	 *   show as erased
+	 */
+	memset(&data[length], 0xff, size - length);
+	return 0;
+}
+
+static unsigned char * findCacheLine(unsigned int address)
+{
+	unsigned int i;
+
+	for(i = 0; i < CACHE_LINES; i++)
+	{
+		if(cache[i].valid && cache[i].address == address)
+			return cache[i].data;
+	}
+
+	return NULL;
+}
+
+static unsigned char * fillCacheLine(unsigned int address, unsigned int end)
+{
+	unsigned char data[CACHE_LINE_SIZE * (1 + READAHEAD_LINES)];
+	unsigned char *line = NULL;
+	unsigned int lines = 1;
+	unsigned int i;
+
+	/**
+	 * the lines that follow are likely to be read next, and reading them
+	 *   along costs less than another read later on
+	 */
+	while(lines < 1 + READAHEAD_LINES && address + (lines + 1) * CACHE_LINE_SIZE <= end && findCacheLine(address + lines * CACHE_LINE_SIZE) == NULL)
+		++lines;
+
+	if(readTarget(address, lines * CACHE_LINE_SIZE, data) != 0)
+		return NULL;
+
+	++server.statistics.cacheMisses;
+	server.statistics.readahead += lines - 1;
+
+	for(i = 0; i < lines; i++)
+	{
+		cache[nextCacheLine].valid = 1;
+		cache[nextCacheLine].address = address + i * CACHE_LINE_SIZE;
+		memcpy(cache[nextCacheLine].data, &data[i * CACHE_LINE_SIZE], CACHE_LINE_SIZE);
+
+		if(i == 0)
+			line = cache[nextCacheLine].data;
+
+		nextCacheLine = (nextCacheLine + 1) % CACHE_LINES;
+	}
+
+	return line;
+}
+
+static int readMemory(unsigned int address, unsigned int size, unsigned char *data)
+{
+	unsigned char *line;
+	unsigned int lineAddress;
+	unsigned int length;
+	unsigned int end;
+	int isCacheable;
+
+	while(size > 0)
+	{
+		if((end = getRegionEnd(address, &isCacheable)) == 0)
+			return -1;
+
+		if(!isCacheable)
+		{
+			length = (size < end - address) ? size : (end - address);
+
+			if(readTarget(address, length, data) != 0)
+				return -1;
+		}
+		else
+		{
+			lineAddress = address & ~(CACHE_LINE_SIZE - 1);
+
+			if((line = findCacheLine(lineAddress)) != NULL)
+				++server.statistics.cacheHits;
+			else if((line = fillCacheLine(lineAddress, end)) == NULL)
+				return -1;
+
+			length = CACHE_LINE_SIZE - (address - lineAddress);
+
+			if(length > size)
+				length = size;
+
+			memcpy(data, &line[address - lineAddress], length);
+		}
+
+		address += length;
+		data += length;
+		size -= length;
+	}
+
+	return 0;
+}
+
+static int writeMemory(unsigned int address, unsigned int size, const unsigned char *data)
+{
+	unsigned char *line;
+	unsigned int end;
+	unsigned int i;
+	int isCacheable;
+
+	if((end = getRegionEnd(address, &isCacheable)) == 0 || size > end - address)
+		return -1;
+
+	if(address >= GDBSERVER_XDATA_OFFSET)
+	{
+		if(ccdbg_writeMemory(server.id, address - GDBSERVER_XDATA_OFFSET, size, data, 1) != 0)
+			return -1;
+
+		/**
+		 * SFRs and SRAM hold the registers
+		 */
+		server.registersValid = 0;
+	}
+	else
+	{
+		if(server.memctr < 0 && (server.memctr = ccdbg_readMemory(server.id, REG_MEMCTR, 0, 0)) < 0)
+			return -1;
+
+		if(ccdbg_writeFlash(server.id, address, size, data, 1) != (int)size)
+			return -1;
+	}
+
+	/**
+	 * write-through
+	 */
+	for(i = 0; isCacheable && i < size; i++)
+	{
+		if((line = findCacheLine((address + i) & ~(CACHE_LINE_SIZE - 1))) != NULL)
+			line[(address + i) & (CACHE_LINE_SIZE - 1)] = data[i];
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ * execution
+ */
+
+static int readRegisters(void)
+{
+	unsigned char sfr[7];
+	CCDBG_MEMORY_OPERATION operations[] = {
+			{ CCDBG_MEMORY_READ, REG_SP, 3, &sfr[0], 0 },		// SP, DPL, DPH
+			{ CCDBG_MEMORY_READ, REG_FMAP, 1, &sfr[3], 0 },
+			{ CCDBG_MEMORY_READ, REG_PSW, 1, &sfr[4], 0 },
+			{ CCDBG_MEMORY_READ, REG_ACC, 1, &sfr[5], 0 },
+			{ CCDBG_MEMORY_READ, REG_B, 1, &sfr[6], 0 }
+	};
+	unsigned int pc;
+	int value;
+
+	if(server.registersValid)
+		return 0;
+
+	if(ccdbg_executeMemoryOperations(server.id, sizeof(operations) / sizeof(operations[0]), operations, 0) != 0)
+		return -1;
+
+	/**
+	 * R0 ~ R7 of the bank selected by PSW.RS
+	 */
+	if(readMemory(GDBSERVER_XDATA_OFFSET + REG_IDATA + (sfr[4] & 0x18), 8, server.registers) != 0)
+		return -1;
+
+	if((value = ccdbg_getPc(server.id)) < 0)
+		return -1;
+
+	pc = (value < FLASH_BANK_SIZE) ? value : ((sfr[3] & 0x7) * FLASH_BANK_SIZE + (value - FLASH_BANK_SIZE));
+
+	server.registers[8] = sfr[5];
+	server.registers[9] = sfr[6];
+	server.registers[10] = sfr[1];
+	server.registers[11] = sfr[2];
+	server.registers[12] = sfr[4];
+	server.registers[13] = sfr[0];
+	server.registers[14] = pc & 0xff;
+	server.registers[15] = (pc >> 8) & 0xff;
+	server.registers[16] = (pc >> 16) & 0xff;
+	server.registers[17] = 0;
+
+	server.registersValid = 1;
+	return 0;
+}
+
+/**
+ * called before the CPU runs again
+ */
+static int leaveHalt(void)
+{
+	unsigned char memctr;
+
+	if(server.memctr >= 0)
+	{
+		memctr = server.memctr;
+
+		if(ccdbg_writeMemory(server.id, REG_MEMCTR, 1, &memctr, 1) != 0)
+			return -1;
+
+		server.memctr = -1;
+	}
+
+	invalidateCache();
+	return 0;
+}
+
+static int setBreakpoint(unsigned int address, int enable)
+{
+	unsigned int codeAddress;
+	int i;
+	int unused = -1;
+
+	if(address >= server.id->flashSize)
+		return -1;
+
+	for(i = 0; i < CCDBG_NUMBER_OF_BREAKPOINTS; i++)
+	{
+		if(server.breakpoints[i].enabled && server.breakpoints[i].address == address)
+			break;
+
+		if(!server.breakpoints[i].enabled && unused < 0)
+			unused = i;
+	}
+
+	if(!enable)
+	{
+		if(i == CCDBG_NUMBER_OF_BREAKPOINTS)
+			return 0;
+
+		server.breakpoints[i].enabled = 0;
+		return ccdbg_setBreakpoint(server.id, i, 0, 0);
+	}
+
+	if(i < CCDBG_NUMBER_OF_BREAKPOINTS)
+		return 0;
+
+	if((i = unused) < 0)
+		return -1;
+
+	/**
+	 * flash address to bank and code address
+	 */
+	if(address < FLASH_BANK_SIZE)
+		codeAddress = address;
+	else
+		codeAddress = ((address / FLASH_BANK_SIZE) << 16) | (FLASH_BANK_SIZE + (address % FLASH_BANK_SIZE));
+
+	if(ccdbg_setBreakpoint(server.id, i, codeAddress, 1) != 0)
+		return -1;
+
+	server.breakpoints[i].enabled = 1;
+	server.breakpoints[i].address = address;
+	return 0;
+}
+
+static int clearBreakpoints(void)
+{
+	int i;
+
+	for(i = 0; i < CCDBG_NUMBER_OF_BREAKPOINTS; i++)
+	{
+		if(server.breakpoints[i].enabled && setBreakpoint(server.breakpoints[i].address, 0) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * resume the CPU and wait for a breakpoint or for GDB's interrupt
+ */
+static int continueExecution(void)
+{
+	int result;
+
+	if(leaveHalt() != 0 || ccdbg_resume(server.id) != 0)
+		return -1;
+
+	for(;;)
+	{
+		if(isInputPending())
+		{
+			if((result = receiveByte()) < 0)
+				return -1;
+
+			if(result == INTERRUPT)
+				return (ccdbg_halt(server.id) == 0) ? SIGNAL_INTERRUPT : -1;
+
+			continue;
+		}
+
+		if((result = ccdbg_isHalted(server.id)) != 0)
+			return (result > 0) ? SIGNAL_TRAP : -1;
+	}
+}
+
+/******************************************************************************
+ * packets
+ */
+
+static int handlePacket(char *packet, char *reply)
+{
+	unsigned char data[MAXIMUM_MEMORY_SIZE];
+	unsigned int address;
+	unsigned int size;
+	unsigned int number;
+	char *end;
+	int result;
+
+	reply[0] = '\0';
+
+	switch(packet[0])
+	{
+	case '?':
+		sprintf(reply, "S%.2x", SIGNAL_TRAP);
+		break;
+
+	case 'g':
+		if(readRegisters() != 0)
+			strcpy(reply, "E01");
+		else
+			bytesToHex(reply, server.registers, REGISTERS_SIZE);
+
+		break;
+
+	case 'p':
+		number = strtoul(&packet[1], NULL, 16);
+
+		if(number >= NUMBER_OF_REGISTERS || readRegisters() != 0)
+			strcpy(reply, "E01");
+		else
+			bytesToHex(reply, &server.registers[number], (number == NUMBER_OF_REGISTERS - 1) ? 4 : 1);
+
+		break;
+
+	case 'm':
+		address = strtoul(&packet[1], &end, 16);
+
+		if(*end != ',' || (size = strtoul(end + 1, NULL, 16)) > MAXIMUM_MEMORY_SIZE || readMemory(address, size, data) != 0)
+			strcpy(reply, "E01");
+		else
+			bytesToHex(reply, data, size);
+
+		break;
+
+	case 'M':
+		address = strtoul(&packet[1], &end, 16);
+
+		if(*end != ',' || (size = strtoul(end + 1, &end, 16)) > MAXIMUM_MEMORY_SIZE || *end != ':' ||
+				strlen(end + 1) != size * 2 || hexToBytes(end + 1, data, size) != 0 || writeMemory(address, size, data) != 0)
+			strcpy(reply, "E01");
+		else
+			strcpy(reply, "OK");
+
+		break;
+
+	case 's':
+		if(leaveHalt() != 0 || ccdbg_stepInstruction(server.id) < 0)
+			strcpy(reply, "E01");
+		else
+			sprintf(reply, "S%.2x", SIGNAL_TRAP);
+
+		break;
+
+	case 'c':
+		if((result = continueExecution()) < 0)
+			return -1;
+
+		sprintf(reply, "S%.2x", result);
+		break;
+
+	case 'Z':
+	case 'z':
+		/**
+		 * software breakpoints would mean rewriting flash pages, so they
+		 *   are hardware breakpoints too
+		 */
+		if((packet[1] != '0' && packet[1] != '1') || packet[2] != ',')
+			break;
+
+		address = strtoul(&packet[3], NULL, 16);
+		strcpy(reply, (setBreakpoint(address, packet[0] == 'Z') == 0) ? "OK" : "E01");
+		break;
+
+	case 'H':
+		strcpy(reply, "OK");
+		break;
+
+	case 'D':
+		strcpy(reply, (clearBreakpoints() == 0 && leaveHalt() == 0 && ccdbg_resume(server.id) == 0) ? "OK" : "E01");
+		sendPacket(reply);
+		return 1;
+
+	case 'k':
+		return 1;
+
+	case 'q':
+		if(strncmp(packet, "qSupported", 10) == 0)
+			sprintf(reply, "PacketSize=%x", PACKET_SIZE);
+		else if(strcmp(packet, "qAttached") == 0)
+			strcpy(reply, "1");
+
+		break;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+int gdbServer_serve(CCDBG_ID id, const char *address, GdbServerStatistics *statistics)
+{
+	char *packet;
+	char *reply;
+	int result = -1;
+
+	if(id == CCDBG_INVALID_ID || id->isLocked)
+		return -1;
+
+	memset(&server, 0, sizeof(server));
+	server.id = id;
+	server.memctr = -1;
+	invalidateCache();
+
+	packet = (char *)malloc(PACKET_SIZE);
+	reply = (char *)malloc(PACKET_SIZE + 1);
+
+	if(packet != NULL && reply != NULL && (server.socket = acceptConnection(address)) >= 0)
+	{
+		/**
+		 * a connection that just goes away counts as ending normally
+		 */
+		result = 0;
+
+		while(result == 0 && receivePacket(packet) >= 0)
+		{
+			if((result = handlePacket(packet, reply)) == 0 && sendPacket(reply) != 0)
+				result = -1;
+		}
+
+		if(result > 0)
+			result = 0;
+
+		close(server.socket);
+	}
+
+	free(packet);
+	free(reply);
+
+	if(statistics != NULL)
+		*statistics = server.statistics;
+
+	return result;
+}
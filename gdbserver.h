@@ -0,0 +1,86 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Billy Millare
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * 18oct2026
+ */
+
+/**
+ * GDB remote serial protocol server
+ *
+ * packets:
+ *   ?, g, p, m, M, s, c, Z0/z0 and Z1/z1 (both hardware breakpoints),
+ *   D, k, qSupported, and qAttached; anything else gets the empty reply
+ *
+ * address spaces:
+ *   0x000000 ~ 0x03ffff	- flash, read from and written to as flash
+ *   0x800000 ~ 0x80ffff	- XDATA, including SRAM, XREGs, and SFRs
+ *
+ * registers, for g and p, little-endian:
+ *   0 ~ 7	- R0 ~ R7 of the register bank selected by PSW
+ *   8		- ACC
+ *   9		- B
+ *   10		- DPL
+ *   11		- DPH
+ *   12		- PSW
+ *   13		- SP
+ *   14		- PC, 4 bytes; flash address of the program counter going by FMAP
+ *
+ * memory reads of flash and SRAM go through a cache of lines that lives
+ *   only while the CPU is halted; a miss also reads ahead the adjacent
+ *   lines that are not cached yet
+ */
+
+#ifndef GDBSERVER_H_
+#define GDBSERVER_H_
+
+#include "ccdbg.h"
+
+/**
+ * NOTE:
+ *   to print error and warning messages, define GDBSERVER_VERBOSE
+ */
+
+#define GDBSERVER_XDATA_OFFSET	0x800000
+
+typedef struct {
+	unsigned int packets;		/* packets received */
+	unsigned int cacheHits;		/* cache lines found in the cache */
+	unsigned int cacheMisses;	/* cache lines read from the chip */
+	unsigned int readahead;		/* cache lines read ahead with the misses */
+	unsigned int targetReads;	/* reads from the chip */
+} GdbServerStatistics;
+
+/**
+ * serve a single GDB connection
+ *
+ * id - chip's identification; the CPU is expected to be halted
+ * address - TCP port on the loopback interface, or path of a Unix socket
+ * statistics - optional; receives counts of packets and cache use
+ *
+ * returns 0 if the connection ended normally, non-zero otherwise
+ *
+ * note: waits for the connection; GDB's interrupt (Ctrl-C) halts a
+ *   running CPU
+ */
+int gdbServer_serve(CCDBG_ID id, const char *address, GdbServerStatistics *statistics);
+
+#endif /* GDBSERVER_H_ */
@@ -27,6 +27,10 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "intelhex.h"
 
 #define PREFIX			"intelhex: "
@@ -60,6 +64,12 @@ enum {
 #define DEFAULT_RECORD_LENGTH	16
 #define BUFFER_SIZE				1024
 
+#define WRITER_BUFFER_SIZE		0x10000
+#define MAXIMUM_RECORD_TEXT_SIZE	(1 + ((4 + 255 + 1) * 2) + 1)
+
+#define MINIMUM_CHUNK_SIZE		0x40000
+#define MAXIMUM_CHUNKS			16
+
 /******************************************************************************
  * other helpers
  */
@@ -121,6 +131,24 @@ static int checkCsAndIp(uint32_t cs, uint32_t ip)
 	return 0;
 }
 
+static uint32_t getEndAddress(uint32_t endAddress, uint32_t lastAddress)
+{
+	/**
+	 * note: the addressing grows with the data, from 8-bit to 16-bit
+	 *       (extended segment) to 32-bit (extended linear)
+	 */
+
+	if(lastAddress > endAddress)
+	{
+		if(lastAddress > MAX_16BIT)
+			endAddress = MAX_32BIT;
+		else if(lastAddress > MAX_8BIT)
+			endAddress = MAX_16BIT;
+	}
+
+	return endAddress;
+}
+
 static int copyData(const uint8_t **sourceData, FILE *sourceFile, uint8_t *destinationData, uint32_t size)
 {
 	if(*sourceData == NULL)
@@ -140,81 +168,161 @@ static int copyData(const uint8_t **sourceData, FILE *sourceFile, uint8_t *desti
 	return 0;
 }
 
+static void * mapFile(FILE *file, uint64_t *size)
+{
+	struct stat status;
+	void *mapping;
+
+	/**
+	 * note: anything that cannot be mapped, e.g. an empty file or a pipe,
+	 *       gives NULL, to be read through stdio instead
+	 */
+
+	if(fstat(fileno(file), &status) != 0 || !S_ISREG(status.st_mode) || status.st_size < 1)
+		return NULL;
+
+	if((mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0)) == MAP_FAILED)
+		return NULL;
+
+	madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+
+	*size = status.st_size;
+	return mapping;
+}
+
 /******************************************************************************
  * hex info helpers
  */
 
-static void freeHexData(IntelHexData *data)
+static inline uint64_t getMemorySize(const IntelHexMemory *memory)
+{
+	return (memory->size == 0) ? 0x100000000ULL : memory->size;
+}
+
+static inline int isMappedHexMemory(const IntelHexMemory *memory)
 {
-	IntelHexData *temp;
+	return (memory->capacity == 0 && memory->data != NULL);
+}
+
+static int reserveHexMemory(IntelHexMemory *memory, uint64_t size)
+{
+	uint64_t capacity;
+	uint8_t *data;
+
+	/**
+	 * note: capacity at least doubles, so appending record after record
+	 *       costs a logarithmic number of reallocations
+	 * note: data in the mapping of the input file is read-only, so it is
+	 *       copied out the first time its memory grows
+	 */
+
+	if(size <= memory->capacity)
+		return 0;
+
+	if((capacity = memory->capacity * 2) < size)
+		capacity = size;
+
+	if(capacity < BUFFER_SIZE)
+		capacity = BUFFER_SIZE;
+
+	if(capacity > 0x100000000ULL)
+		capacity = 0x100000000ULL;
 
-	while((temp = data) != NULL)
+	if((data = (uint8_t *)realloc(isMappedHexMemory(memory) ? NULL : memory->data, capacity)) == NULL)
 	{
-		data = data->next;
-		free(temp);
+		ERROR("failed to allocate %llu bytes of hex memory data\n", (unsigned long long)capacity);
+		return -1;
 	}
+
+	if(isMappedHexMemory(memory))
+		memcpy(data, memory->data, getMemorySize(memory));
+
+	memory->data = data;
+	memory->capacity = capacity;
+	return 0;
 }
 
-static inline IntelHexData * copyHexData(const uint8_t *sourceData, FILE *sourceFile, IntelHexData **destinationData, uint64_t size)
+static void freeHexMemory(IntelHexMemory *memory)
+{
+	if(memory->data != NULL && !isMappedHexMemory(memory))
+		free(memory->data);
+
+	free(memory);
+}
+
+static uint32_t findHexRegion(const IntelHex *hex, uint32_t address)
 {
-	IntelHexData *data = NULL;
-	IntelHexData *tail = NULL;
-	IntelHexData *temp;
-	uint32_t chunkSize;
+	uint32_t lastRegion = hex->lastRegion;
+	uint32_t low;
+	uint32_t high;
+	uint32_t middle;
 
 	/**
-	 * note: data capacity of IntelHexData structure is always BUFFER_SIZE bytes
+	 * note: returns the number of regions with base address at or below
+	 *       address; sequential records fall right after the last region
+	 *       used, so that is checked before searching
 	 */
 
-	if(*destinationData != NULL && (chunkSize = BUFFER_SIZE - (*destinationData)->size) > 0)
-	{
-		if(chunkSize > size)
-			chunkSize = size;
+	if(lastRegion < hex->numberOfRegions && hex->regions[lastRegion]->baseAddress <= address &&
+			((lastRegion + 1) == hex->numberOfRegions || address < hex->regions[lastRegion + 1]->baseAddress))
+		return lastRegion + 1;
 
-		if(copyData(&sourceData, sourceFile, &(*destinationData)->data[(*destinationData)->size], chunkSize) != 0)
-			return NULL;
+	for(low = 0, high = hex->numberOfRegions; low < high; )
+	{
+		middle = low + ((high - low) / 2);
 
-		(*destinationData)->size += chunkSize;
-		size -= chunkSize;
+		if(hex->regions[middle]->baseAddress <= address)
+			low = middle + 1;
+		else
+			high = middle;
 	}
 
-	while(size > 0)
-	{
-		chunkSize = (size > BUFFER_SIZE) ? BUFFER_SIZE : size;
+	return low;
+}
 
-		if((temp = (IntelHexData *)malloc(sizeof(IntelHexData) + BUFFER_SIZE)) == NULL)
-		{
-			ERROR("failed to allocate memory for IntelHexData structure\n");
-			freeHexData(data);
-			return NULL;
-		}
+static IntelHexMemory * findHexMemory(const IntelHex *hex, uint32_t address)
+{
+	IntelHexMemory *memory;
+	uint32_t i;
 
-		temp->next = NULL;
-		temp->size = chunkSize;
-		temp->data = (uint8_t *)temp + sizeof(IntelHexData);
+	if((i = findHexRegion(hex, address)) < 1)
+		return NULL;
 
-		if(tail == NULL)
-			data = temp;
-		else
-			tail->next = temp;
+	memory = hex->regions[i - 1];
+
+	return ((uint64_t)(address - memory->baseAddress) < getMemorySize(memory)) ? memory : NULL;
+}
+
+static int insertHexRegion(IntelHex *hex, uint32_t position, IntelHexMemory *memory)
+{
+	IntelHexMemory **regions;
+	uint32_t capacity;
 
-		tail = temp;
+	if(hex->numberOfRegions == hex->regionsCapacity)
+	{
+		capacity = (hex->regionsCapacity == 0) ? 16 : (hex->regionsCapacity * 2);
 
-		if(copyData(&sourceData, sourceFile, tail->data, chunkSize) != 0)
+		if((regions = (IntelHexMemory **)realloc(hex->regions, capacity * sizeof(IntelHexMemory *))) == NULL)
 		{
-			freeHexData(data);
-			return NULL;
+			ERROR("failed to allocate memory for hex memory index\n");
+			return -1;
 		}
 
-		size -= chunkSize;
+		hex->regions = regions;
+		hex->regionsCapacity = capacity;
 	}
 
-	if(*destinationData == NULL)
-		*destinationData = data;
-	else
-		(*destinationData)->next = data;
+	memmove(&hex->regions[position + 1], &hex->regions[position], (hex->numberOfRegions - position) * sizeof(IntelHexMemory *));
+	hex->regions[position] = memory;
+	hex->numberOfRegions++;
 
-	return (tail == NULL) ? *destinationData : tail;
+	return 0;
+}
+
+static void removeHexRegion(IntelHex *hex, uint32_t position)
+{
+	hex->numberOfRegions--;
+	memmove(&hex->regions[position], &hex->regions[position + 1], (hex->numberOfRegions - position) * sizeof(IntelHexMemory *));
 }
 
 int intelHex_initializeHexInfo(IntelHex *hex, uint32_t flags)
@@ -226,6 +334,12 @@ int intelHex_initializeHexInfo(IntelHex *hex, uint32_t flags)
 	hex->cs = INTEL_HEX_INVALID_ADDRESS;
 	hex->ip = INTEL_HEX_INVALID_ADDRESS;
 	hex->memory = NULL;
+	hex->regions = NULL;
+	hex->numberOfRegions = 0;
+	hex->regionsCapacity = 0;
+	hex->lastRegion = 0;
+	hex->mapping = NULL;
+	hex->mappingSize = 0;
 
 	switch(INTEL_HEX_FLAGS_ADDRESSING(flags))
 	{
@@ -251,14 +365,6 @@ int intelHex_initializeHexInfo(IntelHex *hex, uint32_t flags)
 	return 0;
 }
 
-static void freeHexMemory(IntelHexMemory *memory)
-{
-	if(memory->head != NULL)
-		freeHexData(memory->head);
-
-	free(memory);
-}
-
 void intelHex_destroyHexInfo(IntelHex *hex)
 {
 	IntelHexMemory *memory;
@@ -269,17 +375,27 @@ void intelHex_destroyHexInfo(IntelHex *hex)
 		freeHexMemory(memory);
 	}
 
+	if(hex->regions != NULL)
+		free(hex->regions);
+
+	if(hex->mapping != NULL)
+		munmap(hex->mapping, hex->mappingSize);
+
 	intelHex_initializeHexInfo(hex, 0);
 }
 
-int intelHex_saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, uint64_t size, uint32_t baseAddress)
+/**
+ * note: with isMapped, data is in the mapping of the input file, and a new
+ *       memory uses it in place instead of copying it
+ */
+static int saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, uint64_t size, uint32_t baseAddress, int isMapped)
 {
 	IntelHexMemory *previousMemory = NULL;
 	IntelHexMemory *currentMemory = NULL;
 	IntelHexMemory *memory;
-	IntelHexData *head;
-	IntelHexData *tail;
+	uint64_t memorySize;
 	uint32_t endAddress;
+	uint32_t position;
 
 	if(hex == NULL)
 	{
@@ -307,77 +423,116 @@ int intelHex_saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, u
 
 	endAddress = baseAddress + size - 1;
 
-	if(endAddress > hex->endAddress)
-	{
-		if(endAddress > MAX_16BIT)
-			hex->endAddress = MAX_32BIT;
-		else if(endAddress > MAX_8BIT)
-			hex->endAddress = MAX_16BIT;
-	}
+	hex->endAddress = getEndAddress(hex->endAddress, endAddress);
 
-	for(currentMemory = hex->memory; currentMemory != NULL; previousMemory = currentMemory, currentMemory = currentMemory->next)
-	{
-		if(endAddress >= currentMemory->baseAddress && baseAddress < (currentMemory->baseAddress + currentMemory->size))
-		{
-			ERROR("hex memory at 0x%.8x ~ 0x%.8x overlapped hex memory at 0x%.8x ~ 0x%.8x\n", baseAddress, endAddress, currentMemory->baseAddress, currentMemory->baseAddress + currentMemory->size - 1);
-			return -1;
-		}
+	/**
+	 * the data goes between the regions before and at position
+	 */
+	position = findHexRegion(hex, baseAddress);
 
-		if(baseAddress < currentMemory->baseAddress)
-			break;
-	}
+	if(position > 0)
+		previousMemory = hex->regions[position - 1];
 
-	if(previousMemory != NULL && (previousMemory->baseAddress + previousMemory->size) == baseAddress)
-	{
+	if(position < hex->numberOfRegions)
+		currentMemory = hex->regions[position];
+
+	if(previousMemory != NULL && (uint64_t)(baseAddress - previousMemory->baseAddress) < getMemorySize(previousMemory))
 		memory = previousMemory;
-		head = previousMemory->tail;
-	}
+	else if(currentMemory != NULL && endAddress >= currentMemory->baseAddress)
+		memory = currentMemory;
 	else
-	{
 		memory = NULL;
-		head = NULL;
-	}
-
-	if((tail = copyHexData(data, file, &head, size)) == NULL)
-		return -1;
 
 	if(memory != NULL)
 	{
-		previousMemory->size += size;
-		previousMemory->tail = tail;
-		head = previousMemory->head;
+		ERROR("hex memory at 0x%.8x ~ 0x%.8x overlapped hex memory at 0x%.8x ~ 0x%.8x\n", baseAddress, endAddress, memory->baseAddress, memory->baseAddress + memory->size - 1);
+		return -1;
 	}
 
-	if(currentMemory != NULL && (endAddress + 1) == currentMemory->baseAddress)
+	if(currentMemory != NULL && (endAddress + 1) != currentMemory->baseAddress)
+		currentMemory = NULL;
+
+	if(previousMemory != NULL && (uint32_t)(previousMemory->baseAddress + previousMemory->size) == baseAddress)
 	{
-		if(memory == NULL)
-		{
-			currentMemory->size += size;
-			tail->next = currentMemory->head;
-			currentMemory->head = head;
-		}
-		else
+		/**
+		 * append to the previous memory, and merge the next one if the data
+		 * closes the gap between them
+		 */
+
+		memorySize = getMemorySize(previousMemory);
+
+		if(reserveHexMemory(previousMemory, memorySize + size + ((currentMemory == NULL) ? 0 : getMemorySize(currentMemory))) != 0)
+			return -1;
+
+		if(copyData(&data, file, &previousMemory->data[memorySize], size) != 0)
+			return -1;
+
+		previousMemory->size += size;
+
+		if(currentMemory != NULL)
 		{
-			memory->size += size;
-			memory->tail->next = currentMemory->head;
-			memory->tail = currentMemory->tail;
-			currentMemory->head = NULL;
+			memcpy(&previousMemory->data[memorySize + size], currentMemory->data, getMemorySize(currentMemory));
+			previousMemory->size += currentMemory->size;
 			previousMemory->next = currentMemory->next;
 			freeHexMemory(currentMemory);
+			removeHexRegion(hex, position);
+		}
+
+		hex->lastRegion = position - 1;
+	}
+	else if(currentMemory != NULL)
+	{
+		/**
+		 * prepend to the next memory
+		 */
+
+		memorySize = getMemorySize(currentMemory);
+
+		if(reserveHexMemory(currentMemory, memorySize + size) != 0)
+			return -1;
+
+		memmove(&currentMemory->data[size], currentMemory->data, memorySize);
+
+		if(copyData(&data, file, currentMemory->data, size) != 0)
+		{
+			memmove(currentMemory->data, &currentMemory->data[size], memorySize);
+			return -1;
 		}
+
+		currentMemory->baseAddress = baseAddress;
+		currentMemory->size += size;
+		hex->lastRegion = position;
 	}
-	else if(memory == NULL)
+	else
 	{
 		if((memory = (IntelHexMemory *)malloc(sizeof(IntelHexMemory))) == NULL)
 		{
-			ERROR("failed to allocate memory for IntelHexData structure\n");
+			ERROR("failed to allocate memory for IntelHexMemory structure\n");
 			return -1;
 		}
 
 		memory->baseAddress = baseAddress;
+		memory->size = 0;
+		memory->capacity = 0;
+		memory->data = NULL;
+
+		if(isMapped && data != NULL)
+			memory->data = (uint8_t *)data;
+		else if(reserveHexMemory(memory, size) != 0 || copyData(&data, file, memory->data, size) != 0)
+		{
+			freeHexMemory(memory);
+			return -1;
+		}
+
 		memory->size = size;
-		memory->head = head;
-		memory->tail = tail;
+
+		if(insertHexRegion(hex, position, memory) != 0)
+		{
+			freeHexMemory(memory);
+			return -1;
+		}
+
+		hex->lastRegion = position;
 
 		if(previousMemory == NULL)
 		{
@@ -394,10 +549,33 @@ int intelHex_saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, u
 	return 0;
 }
 
-int intelHex_copyDataFromHexInfo(IntelHex *hex, uint32_t baseAddress, uint8_t *data, FILE *file, uint64_t size)
+int intelHex_saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, uint64_t size, uint32_t baseAddress)
+{
+	return saveDataToHexInfo(hex, data, file, size, baseAddress, 0);
+}
+
+const uint8_t * intelHex_getData(const IntelHex *hex, uint32_t baseAddress, uint64_t size)
 {
 	IntelHexMemory *memory;
-	uint32_t endAddress;
+	uint64_t offset;
+
+	if(hex == NULL || size < 1)
+		return NULL;
+
+	if((memory = findHexMemory(hex, baseAddress)) == NULL)
+		return NULL;
+
+	offset = baseAddress - memory->baseAddress;
+
+	if(size > (getMemorySize(memory) - offset))
+		return NULL;
+
+	return &memory->data[offset];
+}
+
+int intelHex_copyDataFromHexInfo(IntelHex *hex, uint32_t baseAddress, uint8_t *data, FILE *file, uint64_t size)
+{
+	const uint8_t *sourceData;
 
 	if(hex == NULL)
 	{
@@ -411,59 +589,32 @@ int intelHex_copyDataFromHexInfo(IntelHex *hex, uint32_t baseAddress, uint8_t *d
 		return -1;
 	}
 
-	for(memory = hex->memory; memory != NULL; memory = memory->next)
+	if(findHexMemory(hex, baseAddress) == NULL)
 	{
-		endAddress = memory->baseAddress + memory->size - 1;
-
-		if(baseAddress >= memory->baseAddress && baseAddress <= endAddress)
-		{
-			IntelHexData *hexData;
-			uint64_t address;
-			uint8_t *sourceData;
-			uint32_t copySize;
-
-			if((baseAddress + size - 1) > endAddress)
-			{
-				ERROR("cannot copy all of the requested memory data\n");
-				return -1;
-			}
-
-			if(data == NULL && file == NULL)
-				return 0;
-
-			address = memory->baseAddress;
-
-			for(hexData = memory->head; ; hexData = hexData->next)
-			{
-				if((address += hexData->size) > baseAddress)
-				{
-					copySize = address - baseAddress;
-					sourceData = &hexData->data[hexData->size - copySize];
-
-					if(copySize > size)
-						copySize = size;
+		ERROR("requested memory data cannot be located\n");
+		return -1;
+	}
 
-					memcpy(data, sourceData, copySize);
-					baseAddress += copySize;
-					data += copySize;
+	if((sourceData = intelHex_getData(hex, baseAddress, size)) == NULL)
+	{
+		ERROR("cannot copy all of the requested memory data\n");
+		return -1;
+	}
 
-					if((size -= copySize) < 1)
-						return 0;
-				}
-			}
-		}
+	if(data != NULL)
+		memcpy(data, sourceData, size);
+	else if(file != NULL && fwrite(sourceData, 1, size, file) != size)
+	{
+		ERROR("failed to write %llu bytes to output file\n", (unsigned long long)size);
+		return -1;
 	}
 
-	ERROR("requested memory data cannot be located\n");
-	return -1;
+	return 0;
 }
 
 static inline int copyHexInfo(const IntelHex *sourceHex, IntelHex *destinationHex, uint32_t flags)
 {
 	IntelHexMemory *memory;
-	IntelHexData *data;
-	uint64_t memorySize;
-	uint64_t totalSize;
 
 	intelHex_initializeHexInfo(destinationHex, flags);
 
@@ -476,40 +627,14 @@ static inline int copyHexInfo(const IntelHex *sourceHex, IntelHex *destinationHe
 
 	for(memory = sourceHex->memory; memory != NULL; memory = memory->next)
 	{
-		if(memory->head == NULL)
+		if(memory->data == NULL || (!isMappedHexMemory(memory) && getMemorySize(memory) > memory->capacity))
 		{
-			ERROR("invalid hex memory information: data=%p\n", memory->head);
+			ERROR("invalid hex memory information: data=%p size=%u capacity=%llu\n", memory->data, memory->size, (unsigned long long)memory->capacity);
 			return -1;
 		}
 
-		memorySize = (memory->size == 0) ? 0x100000000ULL : memory->size;
-		totalSize = 0;
-
-		for(data = memory->head; data != NULL; data = data->next)
-		{
-			if(data->data == NULL || data->size < 1)
-			{
-				ERROR("invalid hex memory data information: data=%p size=%u\n", data->data, data->size);
-				return -1;
-			}
-
-			if(intelHex_saveDataToHexInfo(destinationHex, data->data, NULL, data->size, memory->baseAddress + totalSize) != 0)
-				return -1;
-
-			totalSize += data->size;
-
-			if(totalSize > memorySize)
-			{
-				ERROR("total hex memory data size, %llu bytes, exceeded expected size, %llu bytes\n", totalSize, memorySize);
-				return -1;
-			}
-		}
-
-		if(totalSize != memorySize)
-		{
-			ERROR("total hex memory data size, %llu bytes, does not match expected size, %llu bytes\n", totalSize, memorySize);
+		if(intelHex_saveDataToHexInfo(destinationHex, memory->data, NULL, getMemorySize(memory), memory->baseAddress) != 0)
 			return -1;
-		}
 	}
 
 	return 0;
@@ -519,22 +644,6 @@ static inline int copyHexInfo(const IntelHex *sourceHex, IntelHex *destinationHe
  * bin file helpers
  */
 
-static int writeValueToBinFile(uint32_t value, FILE *file)
-{
-	uint8_t byte;
-	int i;
-
-	for(i = 0; i < 4; i++)
-	{
-		byte = (value >> (i * 8)) & 0xff;
-
-		if(fwrite(&byte, 1, 1, file) != 1)
-			return -1;
-	}
-
-	return 0;
-}
-
 static int readValueFromBinFile(uint32_t *value, FILE *file)
 {
 	uint8_t byte;
@@ -553,56 +662,6 @@ static int readValueFromBinFile(uint32_t *value, FILE *file)
 	return 0;
 }
 
-static inline int writeHexInfoToBinFile(IntelHex *hex, FILE *file)
-{
-	IntelHexMemory *memory;
-	IntelHexData *data;
-
-	if(writeValueToBinFile(hex->eip, file) != 0)
-	{
-		ERROR("failed to write EIP info to bin file\n");
-		return -1;
-	}
-
-	if(writeValueToBinFile(hex->cs, file) != 0)
-	{
-		ERROR("failed to write CS info to bin file\n");
-		return -1;
-	}
-
-	if(writeValueToBinFile(hex->ip, file) != 0)
-	{
-		ERROR("failed to write IP info to bin file\n");
-		return -1;
-	}
-
-	for(memory = hex->memory; memory != NULL; memory = memory->next)
-	{
-		if(writeValueToBinFile(memory->baseAddress, file) != 0)
-		{
-			ERROR("failed to write data base address info to bin file\n");
-			return -1;
-		}
-
-		if(writeValueToBinFile(memory->size, file) != 0)
-		{
-			ERROR("failed to write data size info to bin file\n");
-			return -1;
-		}
-
-		for(data = memory->head; data != NULL; data = data->next)
-		{
-			if(fwrite(data->data, 1, data->size, file) != data->size)
-			{
-				ERROR("failed to write %u bytes of data to bin file\n", data->size);
-				return -1;
-			}
-		}
-	}
-
-	return 0;
-}
-
 static int readHexInfoFromBinFile(FILE *file, IntelHex *hex, uint32_t flags)
 {
 	uint32_t baseAddress;
@@ -664,264 +723,274 @@ static int readHexInfoFromBinFile(FILE *file, IntelHex *hex, uint32_t flags)
 	return 0;
 }
 
-/******************************************************************************
- * hex file helpers
- */
-
-static int readValueFromHexFile(FILE *file, int size, uint32_t *value)
+static int readValueFromBinData(uint32_t *value, const uint8_t **data, const uint8_t *end)
 {
-	/**
-	 * note: value in file is big-endian
-	 */
-
-	int hex;
+	const uint8_t *bytes = *data;
 
-	*value = 0;
+	if((end - bytes) < 4)
+		return -1;
 
-	while(size-- > 0)
-	{
-		hex = fgetc(file);
-
-		if(!isxdigit(hex))
-			return -1;
-
-		if(isdigit(hex))
-			hex -= '0';
-		else
-			hex = tolower(hex) - 'a' + 10;
-
-		*value |= (hex << (4 * size));
-	}
-
-	return 0;
-}
-
-static int writeDataToHexFile(FILE *file, int size, const uint8_t *data, int *sum)
-{
-	int temp = 0;
-	int i;
-
-	if(sum == NULL)
-		sum = &temp;
-
-	for(i = 0; i < size; i++)
-	{
-		*sum += data[i];
-
-		if(fprintf(file, "%.2x", data[i]) != 2)
-			return -1;
-	}
+	*value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	*data += 4;
 
 	return 0;
 }
 
-static int writeValueToHexFile(FILE *file, int size, uint32_t value, int *sum)
+static int readHexInfoFromMappedBinFile(FILE *file, IntelHex *hex, uint32_t flags)
 {
-	uint8_t data[4];
-	int i;
-
-	for(i = 0; size-- > 0; i++)
-		data[i] = (uint8_t)((value >> (size * 8)) & 0xff);
-
-	return writeDataToHexFile(file, i, data, sum);
-}
+	const uint8_t *data;
+	const uint8_t *end;
+	uint64_t length;
+	uint64_t memorySize;
+	uint32_t baseAddress;
+	uint32_t size;
 
-static int writeHexRecordToHexFile(FILE *file, uint32_t type, uint32_t length, uint32_t offset, const void *data)
-{
 	/**
-	 * |:|cc|oooo|tt|dd..dd|ss|
+	 * note: memory chunks are used in place, so the mapping stays until hex
+	 *       is destroyed; chunks that adjoin another are copied when merged
 	 */
 
-	int checksum = 0;
+	if((data = (const uint8_t *)mapFile(file, &length)) == NULL)
+		return readHexInfoFromBinFile(file, hex, flags);
+
+	intelHex_initializeHexInfo(hex, flags);
+
+	hex->mapping = (void *)data;
+	hex->mappingSize = length;
+	end = &data[length];
 
-	if(fputc(':', file) != ':')
+	if(readValueFromBinData(&hex->eip, &data, end) != 0)
 	{
-		ERROR("failed to write record mark to hex file\n");
+		ERROR("failed to read EIP info from bin file\n");
 		return -1;
 	}
 
-	if(writeValueToHexFile(file, 1, length, &checksum) != 0)
+	if(readValueFromBinData(&hex->cs, &data, end) != 0)
 	{
-		ERROR("failed to write record byte count info to hex file\n");
+		ERROR("failed to read CS info from bin file\n");
 		return -1;
 	}
 
-	if(writeValueToHexFile(file, 2, offset, &checksum) != 0)
+	if(readValueFromBinData(&hex->ip, &data, end) != 0)
 	{
-		ERROR("failed to write record address offset info to hex file\n");
+		ERROR("failed to read IP info from bin file\n");
 		return -1;
 	}
 
-	if(writeValueToHexFile(file, 1, type, &checksum) != 0)
-	{
-		ERROR("failed to write record type info to hex file\n");
+	if(checkEip(hex->eip) != 0 || checkCsAndIp(hex->cs, hex->ip) != 0)
 		return -1;
-	}
 
-	if(type == INTEL_HEX_RECORD_DATA)
+	while(data < end)
 	{
-		if(writeDataToHexFile(file, length, (uint8_t *)data, &checksum) != 0)
+		if(readValueFromBinData(&baseAddress, &data, end) != 0)
 		{
-			ERROR("failed to write record data to hex file\n");
+			ERROR("failed to read data base address info from bin file\n");
 			return -1;
 		}
-	}
-	else if(type != INTEL_HEX_RECORD_END_OF_FILE)
-	{
-		if(writeValueToHexFile(file, length, *((uint32_t *)data), &checksum) != 0)
+
+		if(readValueFromBinData(&size, &data, end) != 0)
+		{
+			ERROR("failed to read data size info from bin file\n");
+			return -1;
+		}
+
+		memorySize = (size == 0) ? 0x100000000ULL : (uint64_t)size;
+
+		if(memorySize > (uint64_t)(end - data))
 		{
-			ERROR("failed to write record data to hex file\n");
+			ERROR("failed to read %llu bytes from input file\n", (unsigned long long)memorySize);
 			return -1;
 		}
-	}
 
-	if(writeValueToHexFile(file, 1, 0x100 - (checksum & 0xff), NULL) != 0)
-	{
-		ERROR("failed to write record checksum info to hex file\n");
-		return -1;
-	}
+		if(saveDataToHexInfo(hex, data, NULL, memorySize, baseAddress, 1) != 0)
+			return -1;
 
-	if(fputc('\n', file) != '\n')
-	{
-		ERROR("failed to write record delimiter to hex file\n");
-		return -1;
+		data += memorySize;
 	}
 
 	return 0;
 }
 
-static inline int writeHexInfoToHexFile(IntelHex *hex, FILE *file, uint32_t recordLength)
+/******************************************************************************
+ * hex file helpers
+ */
+
+static const char hexDigits[] = "0123456789abcdef";
+
+/**
+ * value of each character as a hex digit, 0xff if it is not one
+ */
+static const uint8_t hexDigitValues[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+static int readValueFromHexFile(FILE *file, int size, uint32_t *value)
 {
-	IntelHexMemory *memory;
-	IntelHexData *data;
-	uint32_t offset;
-	uint32_t length;
-	uint64_t baseAddress;
-	uint64_t endAddress;
-	uint64_t memorySize;
-	uint32_t size;
-	uint32_t address;
-	uint32_t type;
-	uint8_t buffer[255];
-	uint8_t *sourceData;
-	uint32_t sourceDataSize;
-	uint32_t copySize;
-	uint32_t remainingSize;
-	uint32_t i;
+	/**
+	 * note: value in file is big-endian
+	 */
 
-	if(recordLength == 0)
-		recordLength = DEFAULT_RECORD_LENGTH;
+	int hex;
 
-	type = (hex->endAddress == MAX_32BIT) ? INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS : INTEL_HEX_RECORD_EXTENDED_SEGMENT_ADDRESS;
+	*value = 0;
 
-	if(IS_VALID_ADDRESS(hex->eip))
+	while(size-- > 0)
 	{
-		if(writeHexRecordToHexFile(file, INTEL_HEX_RECORD_START_LINEAR_ADDRESS, 4, 0, &hex->eip) != 0)
-		{
-			ERROR("failed to write start linear address record to hex file\n");
+		hex = fgetc(file);
+
+		if(!isxdigit(hex))
 			return -1;
-		}
+
+		if(isdigit(hex))
+			hex -= '0';
+		else
+			hex = tolower(hex) - 'a' + 10;
+
+		*value |= (hex << (4 * size));
 	}
 
-	if(IS_VALID_ADDRESS(hex->cs)) // and IP
-	{
-		address = (hex->cs << 16) | hex->ip;
+	return 0;
+}
 
-		if(writeHexRecordToHexFile(file, INTEL_HEX_RECORD_START_SEGMENT_ADDRESS, 4, 0, &address) != 0)
-		{
-			ERROR("failed to write start segment address record to hex file\n");
-			return -1;
-		}
+static int saveHexData(IntelHex *hex, const uint8_t *data, uint64_t size, uint32_t baseAddress, IntelHexDataHandler handler, void *context)
+{
+	if(handler == NULL)
+		return intelHex_saveDataToHexInfo(hex, data, NULL, size, baseAddress);
+
+	if(baseAddress > hex->endmostAddress || (size - 1) > (hex->endmostAddress - baseAddress))
+	{
+		ERROR("hex memory at 0x%.8x with %llu bytes exceeded the maximum address of 0x%.8x\n", baseAddress, (unsigned long long)size, hex->endmostAddress);
+		return -1;
 	}
 
-	for(memory = hex->memory; memory != NULL; memory = memory->next)
+	return handler(context, baseAddress, data, size);
+}
+
+static int saveHexRecord(IntelHex *hex, uint32_t recordType, uint32_t byteCount, uint32_t offset, const uint8_t *buffer, uint32_t flags, uint32_t *baseAddress, int *isLinear, IntelHexDataHandler handler, void *context)
+{
+	const uint8_t *data;
+	uint32_t address;
+	uint64_t size;
+
+	if(recordType == INTEL_HEX_RECORD_DATA)
 	{
-		baseAddress = memory->baseAddress;
-		memorySize = (memory->size == 0) ? 0x100000000ULL : memory->size;
-		endAddress = baseAddress + memorySize;
-		data = memory->head;
-		sourceData = NULL;
-		sourceDataSize = 0;
+		data = buffer;
 
-		while(baseAddress < endAddress)
+		while(byteCount > 0)
 		{
-			if(hex->endAddress == MAX_8BIT)
+			if(*isLinear)
 			{
-				size = memorySize;
-				offset = baseAddress;
+				address = (*baseAddress + offset) & MAX_32BIT;
+				size = (uint64_t)(MAX_32BIT - address) + 1ULL;
+
+				if(size > byteCount)
+					size = byteCount;
 			}
 			else
 			{
-				if(hex->endAddress == MAX_32BIT)
-				{
-					offset = baseAddress & 0xffff;
-					address = baseAddress >> 16;
-				}
-				else
-				{
-					offset = baseAddress & 0xf;
-					address = baseAddress >> 4;
-				}
-
-				if(writeHexRecordToHexFile(file, type, 2, 0, &address) != 0)
-				{
-					ERROR("failed to write extended %s address record to hex file\n", (type == INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS) ? "linear" : "segment");
-					return -1;
-				}
-
-				if((size = 0x10000 - offset) > memorySize)
-					size = memorySize;
+				offset &= 0xffff;
+				address = *baseAddress + offset;
+				size = ((offset + byteCount) > 0x10000) ? (0x10000 - offset) : byteCount;
 			}
 
-			for(i = 0; i < size; i += length)
-			{
-				length = size - i;
+			if(saveHexData(hex, data, size, address, handler, context) != 0)
+				return -1;
 
-				if(length > recordLength)
-					length = recordLength;
+			data += size;
+			byteCount -= size;
+			offset += size;
+		}
+	}
+	else if(recordType == INTEL_HEX_RECORD_END_OF_FILE)
+	{
+		if(byteCount != 0 || offset != 0x0000)
+		{
+			ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
+			return -1;
+		}
+	}
+	else if(recordType == INTEL_HEX_RECORD_EXTENDED_SEGMENT_ADDRESS)
+	{
+		if(byteCount != 2 || offset != 0x0000)
+		{
+			ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
+			return -1;
+		}
 
-				for(remainingSize = length; remainingSize > 0; )
-				{
-					if(sourceData == NULL)
-					{
-						sourceData = data->data;
-						sourceDataSize = data->size;
-						data = data->next;
-					}
-
-					copySize = (sourceDataSize > remainingSize) ? remainingSize : sourceDataSize;
-					memcpy(&buffer[length - remainingSize], sourceData, copySize);
-
-					if((sourceDataSize -= copySize) < 1)
-						sourceData = NULL;
-					else
-						sourceData += copySize;
-
-					remainingSize -= copySize;
-				}
+		*baseAddress = (buffer[0] << 8 | buffer[1]) << 4;
+		*isLinear = 0;
+	}
+	else if(recordType == INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS)
+	{
+		if(byteCount != 2 || offset != 0x0000)
+		{
+			ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
+			return -1;
+		}
 
-				if(writeHexRecordToHexFile(file, INTEL_HEX_RECORD_DATA, length, offset + i, buffer) != 0)
-				{
-					ERROR("failed to write data record to hex file\n");
-					return -1;
-				}
-			}
+		*baseAddress = (buffer[0] << 8 | buffer[1]) << 16;
+		*isLinear = 1;
+	}
+	else if(recordType == INTEL_HEX_RECORD_START_LINEAR_ADDRESS)
+	{
+		if(byteCount != 4 || offset != 0x0000)
+		{
+			ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
+			return -1;
+		}
 
-			baseAddress += size;
-			memorySize -= size;
+		if(IS_VALID_ADDRESS(hex->eip))
+		{
+			ERROR("duplicate record for start linear address (EIP)\n");
+			return -1;
 		}
+
+		hex->eip = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
 	}
+	else if(recordType == INTEL_HEX_RECORD_START_SEGMENT_ADDRESS)
+	{
+		if(byteCount != 4 || offset != 0x0000)
+		{
+			ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
+			return -1;
+		}
+
+		if(IS_VALID_ADDRESS(hex->cs)) // and IP
+		{
+			ERROR("duplicate record for start segment address (CS and IP)\n");
+			return -1;
+		}
 
-	if(writeHexRecordToHexFile(file, INTEL_HEX_RECORD_END_OF_FILE, 0, 0, NULL) != 0)
+		hex->cs = (buffer[0] << 8) | buffer[1];
+		hex->ip = (buffer[2] << 8) | buffer[3];
+	}
+	else if((flags & INTEL_HEX_IGNORE_UNKNOWN_RECORD))
+		WARNING("unknown record of type 0x%x\n", recordType);
+	else
 	{
-		ERROR("failed to write end-of-file record to hex file\n");
+		ERROR("unknown record of type 0x%x\n", recordType);
 		return -1;
 	}
 
 	return 0;
 }
 
-static int readHexInfoFromHexFile(FILE *file, IntelHex *hex, uint32_t flags)
+static int readHexRecordsFromHexFile(FILE *file, IntelHex *hex, uint32_t flags, IntelHexDataHandler handler, void *context)
 {
 	int notFirstRecord = 0;
 	int isLinear = 1;
@@ -932,9 +1001,6 @@ static int readHexInfoFromHexFile(FILE *file, IntelHex *hex, uint32_t flags)
 	uint32_t offset;
 	uint32_t value;
 	uint32_t checksum;
-	uint32_t address;
-	uint64_t size;
-	uint8_t *data;
 	int hasNewline;
 	int i;
 
@@ -961,269 +1027,2155 @@ static int readHexInfoFromHexFile(FILE *file, IntelHex *hex, uint32_t flags)
 			return -1;
 		}
 
-		if(i != ':')
-		{
-			ERROR("record mark not found in hex file\n");
-			return -1;
-		}
+		if(i != ':')
+		{
+			ERROR("record mark not found in hex file\n");
+			return -1;
+		}
+
+		if(readValueFromHexFile(file, 2, &byteCount) != 0)
+		{
+			ERROR("failed to read record byte count info from hex file\n");
+			return -1;
+		}
+
+		if(readValueFromHexFile(file, 4, &offset) != 0)
+		{
+			ERROR("failed to read record address offset info from hex file\n");
+			return -1;
+		}
+
+		if(readValueFromHexFile(file, 2, &recordType) != 0)
+		{
+			ERROR("failed to read record type info from hex file\n");
+			return -1;
+		}
+
+		checksum = byteCount + (offset & 0xff) + (offset >> 8) + recordType;
+
+		for(i = 0; (uint32_t)i < byteCount; i++)
+		{
+			if(readValueFromHexFile(file, 2, &value) != 0)
+			{
+				ERROR("failed to read record data byte from hex file\n");
+				return -1;
+			}
+
+			buffer[i] = (uint8_t)value;
+			checksum += value;
+		}
+
+		if(readValueFromHexFile(file, 2, &value) != 0)
+		{
+			ERROR("failed to read record checksum info from hex file\n");
+			return -1;
+		}
+
+		if(((checksum + value) & 0xff) != 0)
+		{
+			ERROR("wrong record checksum\n");
+			return -1;
+		}
+
+		if(saveHexRecord(hex, recordType, byteCount, offset, buffer, flags, &baseAddress, &isLinear, handler, context) != 0)
+			return -1;
+
+		notFirstRecord = 1;
+	}
+
+	return -1;
+}
+
+static inline int readHexInfoFromHexFile(FILE *file, IntelHex *hex, uint32_t flags)
+{
+	return readHexRecordsFromHexFile(file, hex, flags, NULL, NULL);
+}
+
+static int decodeHexText(const uint8_t **text, const uint8_t *end, uint32_t size, uint8_t *data, uint32_t *sum)
+{
+	/**
+	 * note: size is in bytes, i.e. pairs of hex digits, most significant
+	 *       digit first
+	 */
+
+	const uint8_t *source = *text;
+	uint32_t high;
+	uint32_t low;
+	uint32_t i;
+
+	if((uint64_t)(end - source) < (uint64_t)size * 2)
+		return -1;
+
+	for(i = 0; i < size; i++, source += 2)
+	{
+		high = hexDigitValues[source[0]];
+		low = hexDigitValues[source[1]];
+
+		if((high | low) > 0x0f)
+			return -1;
+
+		data[i] = (uint8_t)((high << 4) | low);
+		*sum += data[i];
+	}
+
+	*text = source;
+	return 0;
+}
+
+static const char * decodeHexRecord(const uint8_t **text, const uint8_t *end, uint8_t *record)
+{
+	/**
+	 * note: record receives the byte count, the address offset (big-endian),
+	 *       the record type, and the data; returns NULL if successful, the
+	 *       error message otherwise
+	 */
+
+	uint32_t checksum = 0;
+	uint8_t value;
+
+	if(*text == end || *(*text)++ != ':')
+		return "record mark not found in hex file";
+
+	if(decodeHexText(text, end, 1, &record[0], &checksum) != 0)
+		return "failed to read record byte count info from hex file";
+
+	if(decodeHexText(text, end, 2, &record[1], &checksum) != 0)
+		return "failed to read record address offset info from hex file";
+
+	if(decodeHexText(text, end, 1, &record[3], &checksum) != 0)
+		return "failed to read record type info from hex file";
+
+	if(decodeHexText(text, end, record[0], &record[4], &checksum) != 0)
+		return "failed to read record data byte from hex file";
+
+	if(decodeHexText(text, end, 1, &value, &checksum) != 0)
+		return "failed to read record checksum info from hex file";
+
+	if((checksum & 0xff) != 0)
+		return "wrong record checksum";
+
+	return NULL;
+}
+
+static inline int saveDecodedHexRecord(IntelHex *hex, const uint8_t *record, uint32_t flags, uint32_t *baseAddress, int *isLinear, IntelHexDataHandler handler, void *context)
+{
+	return saveHexRecord(hex, record[3], record[0], (record[1] << 8) | record[2], &record[4], flags, baseAddress, isLinear, handler, context);
+}
+
+static int readHexRecordsFromHexText(const uint8_t *text, uint64_t length, IntelHex *hex, uint32_t flags, IntelHexDataHandler handler, void *context)
+{
+	const uint8_t *end = text + length;
+	const char *error;
+	int notFirstRecord = 0;
+	int isLinear = 1;
+	uint32_t baseAddress = 0x00000000;
+	uint8_t record[4 + 255];
+	int hasNewline;
+
+	/**
+	 * same records, checks, and errors as readHexRecordsFromHexFile(), with the
+	 * whole file in memory and hex digits decoded through a table
+	 */
+
+	intelHex_initializeHexInfo(hex, flags);
+	record[3] = INTEL_HEX_RECORD_DATA;
+
+	while(1)
+	{
+		for(hasNewline = 0; text < end && isspace(*text); hasNewline |= (*text == '\r' || *text == '\n'), text++);
+
+		if(record[3] == INTEL_HEX_RECORD_END_OF_FILE)
+		{
+			if(text != end)
+			{
+				ERROR("EOF not found in hex file\n");
+				return -1;
+			}
+
+			return 0;
+		}
+
+		if(notFirstRecord && !hasNewline)
+		{
+			ERROR("record delimiter not found in hex file\n");
+			return -1;
+		}
+
+		if((error = decodeHexRecord(&text, end, record)) != NULL)
+		{
+			ERROR("%s\n", error);
+			return -1;
+		}
+
+		if(saveDecodedHexRecord(hex, record, flags, &baseAddress, &isLinear, handler, context) != 0)
+			return -1;
+
+		notFirstRecord = 1;
+	}
+
+	return -1;
+}
+
+static inline int readHexInfoFromHexText(const uint8_t *text, uint64_t length, IntelHex *hex, uint32_t flags)
+{
+	return readHexRecordsFromHexText(text, length, hex, flags, NULL, NULL);
+}
+
+/**
+ * a piece of a hex file, from a record mark up to the start of a later
+ *   record, decoded by its own thread
+ */
+typedef struct {
+	pthread_t thread;
+	const uint8_t *text;
+	const uint8_t *end;
+	uint8_t *records;		/* decoded records, back to back */
+	uint8_t *recordsEnd;
+	int hasEndOfFile;
+	int status;
+} HexTextChunk;
+
+static void * decodeHexTextChunk(void *argument)
+{
+	HexTextChunk *chunk = (HexTextChunk *)argument;
+	const uint8_t *text = chunk->text;
+	uint8_t *record = chunk->records;
+	int notFirstRecord = 0;
+	int hasNewline;
+
+	/**
+	 * note: only checks and decodes records; failures are not reported here
+	 *       since the whole file is read again serially to report them
+	 */
+
+	chunk->hasEndOfFile = 0;
+	chunk->status = -1;
+
+	while(1)
+	{
+		for(hasNewline = 0; text < chunk->end && isspace(*text); hasNewline |= (*text == '\r' || *text == '\n'), text++);
+
+		if(text == chunk->end)
+			break;
+
+		if(chunk->hasEndOfFile || (notFirstRecord && !hasNewline))
+			return NULL;
+
+		if(decodeHexRecord(&text, chunk->end, record) != NULL)
+			return NULL;
+
+		chunk->hasEndOfFile = (record[3] == INTEL_HEX_RECORD_END_OF_FILE);
+		record += 4 + record[0];
+		notFirstRecord = 1;
+	}
+
+	chunk->recordsEnd = record;
+	chunk->status = 0;
+
+	return NULL;
+}
+
+static int getNumberOfHexTextChunks(uint64_t length)
+{
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t chunks = length / MINIMUM_CHUNK_SIZE;
+
+	if(processors < 1)
+		processors = 1;
+
+	if(chunks > (uint64_t)processors)
+		chunks = processors;
+
+	if(chunks > MAXIMUM_CHUNKS)
+		chunks = MAXIMUM_CHUNKS;
+
+	return (chunks < 1) ? 1 : (int)chunks;
+}
+
+static int readHexInfoFromHexTextInParallel(const uint8_t *text, uint64_t length, IntelHex *hex, uint32_t flags, int numberOfChunks)
+{
+	const uint8_t *end = text + length;
+	HexTextChunk chunks[MAXIMUM_CHUNKS];
+	uint64_t chunkSize;
+	const uint8_t *record;
+	const uint8_t *start;
+	const uint8_t *split;
+	int isLinear = 1;
+	uint32_t baseAddress = 0x00000000;
+	int status = 0;
+	int started;
+	int i;
+
+	/**
+	 * the file is split after line breaks into chunks that threads decode
+	 * at the same time; the decoded records are then saved in file order,
+	 * which keeps track of the extended address records and builds the
+	 * memory regions exactly as reading serially does
+	 *
+	 * note: anything wrong in any chunk sends the whole file to the serial
+	 *       reader, so that it fails with the same error as it always has
+	 */
+
+	if(numberOfChunks > MAXIMUM_CHUNKS)
+		numberOfChunks = MAXIMUM_CHUNKS;
+
+	chunkSize = length / numberOfChunks;
+
+	for(i = 0, start = text; i < numberOfChunks; i++)
+	{
+		chunks[i].text = start;
+		chunks[i].end = end;
+
+		if(i < (numberOfChunks - 1))
+		{
+			if((split = text + chunkSize * (i + 1)) < start)
+				split = start;
+
+			if((split = (const uint8_t *)memchr(split, '\n', end - split)) != NULL)
+				chunks[i].end = split + 1;
+		}
+
+		for(start = chunks[i].end; start < end && isspace(*start); start++);
+
+		if(start == end)
+		{
+			chunks[i].end = end;
+			numberOfChunks = i + 1;
+		}
+	}
+
+	for(started = 0; started < numberOfChunks; started++)
+	{
+		chunks[started].status = -1;
+
+		if((chunks[started].records = (uint8_t *)malloc(((chunks[started].end - chunks[started].text) / 2) + 4)) == NULL)
+			break;
+
+		if(started > 0 && pthread_create(&chunks[started].thread, NULL, decodeHexTextChunk, &chunks[started]) != 0)
+		{
+			free(chunks[started].records);
+			break;
+		}
+	}
+
+	if(started > 0)
+		decodeHexTextChunk(&chunks[0]);
+
+	for(i = 1; i < started; i++)
+		pthread_join(chunks[i].thread, NULL);
+
+	if(started < numberOfChunks)
+		status = -1;
+
+	for(i = 0; i < started && status == 0; i++)
+	{
+		if(chunks[i].status != 0 || chunks[i].hasEndOfFile != (i == (numberOfChunks - 1)))
+			status = -1;
+	}
+
+	if(status != 0)
+	{
+		for(i = 0; i < started; i++)
+			free(chunks[i].records);
+
+		return readHexInfoFromHexText(text, length, hex, flags);
+	}
+
+	/**
+	 * note: every record is known to be well-formed by now, so saving them
+	 *       fails on the same record, with the same error, as the serial
+	 *       reader would
+	 */
+
+	intelHex_initializeHexInfo(hex, flags);
+
+	for(i = 0; i < numberOfChunks && status == 0; i++)
+	{
+		for(record = chunks[i].records; record < chunks[i].recordsEnd && status == 0; record += 4 + record[0])
+			status = saveDecodedHexRecord(hex, record, flags, &baseAddress, &isLinear, NULL, NULL);
+	}
+
+	for(i = 0; i < started; i++)
+		free(chunks[i].records);
+
+	return status;
+}
+
+static int readHexInfoFromMappedHexFile(FILE *file, IntelHex *hex, uint32_t flags, int numberOfChunks, IntelHexDataHandler handler, void *context)
+{
+	uint64_t length;
+	void *text;
+	int result;
+
+	if((text = mapFile(file, &length)) == NULL)
+		return readHexRecordsFromHexFile(file, hex, flags, handler, context);
+
+	if(numberOfChunks < 1)
+		numberOfChunks = getNumberOfHexTextChunks(length);
+
+	/**
+	 * note: data handed to a handler is read serially, in file order
+	 */
+	if(numberOfChunks > 1 && handler == NULL)
+		result = readHexInfoFromHexTextInParallel((const uint8_t *)text, length, hex, flags, numberOfChunks);
+	else
+		result = readHexRecordsFromHexText((const uint8_t *)text, length, hex, flags, handler, context);
+
+	munmap(text, length);
+	return result;
+}
+
+/******************************************************************************
+ * writer helpers
+ */
+
+static int flushWriter(IntelHexWriter *writer)
+{
+	if(writer->size > 0 && fwrite(writer->buffer, 1, writer->size, writer->file) != writer->size)
+	{
+		ERROR("failed to write %u bytes to %s file\n", writer->size, (writer->format == INTEL_HEX_FORMAT_HEX) ? "hex" : "bin");
+		return -1;
+	}
+
+	writer->size = 0;
+	return 0;
+}
+
+static int writeValueToBinFile(IntelHexWriter *writer, uint32_t value)
+{
+	uint8_t *data;
+
+	if((WRITER_BUFFER_SIZE - writer->size) < 4 && flushWriter(writer) != 0)
+		return -1;
+
+	data = &writer->buffer[writer->size];
+	data[0] = value & 0xff;
+	data[1] = (value >> 8) & 0xff;
+	data[2] = (value >> 16) & 0xff;
+	data[3] = (value >> 24) & 0xff;
+	writer->size += 4;
+
+	return 0;
+}
+
+static inline uint8_t * encodeHexByte(uint8_t *text, uint32_t value, uint32_t *sum)
+{
+	*text++ = hexDigits[(value >> 4) & 0x0f];
+	*text++ = hexDigits[value & 0x0f];
+	*sum += value;
+
+	return text;
+}
+
+static int writeHexRecordToHexFile(IntelHexWriter *writer, uint32_t type, uint32_t length, uint32_t offset, const uint8_t *data)
+{
+	/**
+	 * |:|cc|oooo|tt|dd..dd|ss|
+	 */
+
+	uint32_t checksum = 0;
+	uint8_t *text;
+	uint32_t i;
+
+	if((WRITER_BUFFER_SIZE - writer->size) < MAXIMUM_RECORD_TEXT_SIZE && flushWriter(writer) != 0)
+		return -1;
+
+	text = &writer->buffer[writer->size];
+	*text++ = ':';
+	text = encodeHexByte(text, length, &checksum);
+	text = encodeHexByte(text, (offset >> 8) & 0xff, &checksum);
+	text = encodeHexByte(text, offset & 0xff, &checksum);
+	text = encodeHexByte(text, type, &checksum);
+
+	for(i = 0; i < length; i++)
+		text = encodeHexByte(text, data[i], &checksum);
+
+	text = encodeHexByte(text, (0x100 - (checksum & 0xff)) & 0xff, &checksum);
+	*text++ = '\n';
+
+	writer->size = text - writer->buffer;
+	return 0;
+}
+
+static int writeValueToHexFile(IntelHexWriter *writer, uint32_t type, uint32_t length, uint32_t value)
+{
+	/**
+	 * note: value in file is big-endian
+	 */
+
+	uint8_t data[4];
+	uint32_t i;
+
+	for(i = 0; i < length; i++)
+		data[i] = (value >> ((length - i - 1) * 8)) & 0xff;
+
+	return writeHexRecordToHexFile(writer, type, length, 0, data);
+}
+
+static int startWriting(IntelHexWriter *writer, int format, FILE *file, uint32_t eip, uint32_t cs, uint32_t ip, uint32_t endAddress, uint32_t flags)
+{
+	writer->file = file;
+	writer->format = format;
+	writer->endAddress = endAddress;
+	writer->recordLength = INTEL_HEX_FLAGS_RECORD_LENGTH(flags);
+	writer->extendedAddress = INTEL_HEX_INVALID_ADDRESS;
+	writer->size = 0;
+
+	if(writer->recordLength == 0)
+		writer->recordLength = DEFAULT_RECORD_LENGTH;
+
+	if((writer->buffer = (uint8_t *)malloc(WRITER_BUFFER_SIZE)) == NULL)
+	{
+		ERROR("failed to allocate memory for writer buffer\n");
+		return -1;
+	}
+
+	if(format == INTEL_HEX_FORMAT_BIN)
+	{
+		if(writeValueToBinFile(writer, eip) != 0 || writeValueToBinFile(writer, cs) != 0 || writeValueToBinFile(writer, ip) != 0)
+		{
+			ERROR("failed to write EIP, CS, and IP info to bin file\n");
+			return -1;
+		}
+
+		return 0;
+	}
+
+	if(IS_VALID_ADDRESS(eip))
+	{
+		if(writeValueToHexFile(writer, INTEL_HEX_RECORD_START_LINEAR_ADDRESS, 4, eip) != 0)
+		{
+			ERROR("failed to write start linear address record to hex file\n");
+			return -1;
+		}
+	}
+
+	if(IS_VALID_ADDRESS(cs)) // and IP
+	{
+		if(writeValueToHexFile(writer, INTEL_HEX_RECORD_START_SEGMENT_ADDRESS, 4, (cs << 16) | ip) != 0)
+		{
+			ERROR("failed to write start segment address record to hex file\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int writeDataToHexFile(IntelHexWriter *writer, uint32_t baseAddress, const uint8_t *data, uint64_t memorySize)
+{
+	uint32_t type = (writer->endAddress == MAX_32BIT) ? INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS : INTEL_HEX_RECORD_EXTENDED_SEGMENT_ADDRESS;
+	uint64_t address = baseAddress;
+	uint64_t endAddress = address + memorySize;
+	uint32_t extendedAddress;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t size;
+	uint32_t i;
+
+	while(address < endAddress)
+	{
+		if(writer->endAddress == MAX_8BIT)
+		{
+			size = memorySize;
+			offset = address;
+		}
+		else
+		{
+			if(writer->endAddress == MAX_32BIT)
+			{
+				offset = address & 0xffff;
+				extendedAddress = address >> 16;
+			}
+			else
+			{
+				offset = address & 0xf;
+				extendedAddress = address >> 4;
+			}
+
+			/**
+			 * note: the extended address record is left out if it is the
+			 *       same as the last one written
+			 */
+			if(extendedAddress != writer->extendedAddress)
+			{
+				if(writeValueToHexFile(writer, type, 2, extendedAddress) != 0)
+				{
+					ERROR("failed to write extended %s address record to hex file\n", (type == INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS) ? "linear" : "segment");
+					return -1;
+				}
+
+				writer->extendedAddress = extendedAddress;
+			}
+
+			if((size = 0x10000 - offset) > memorySize)
+				size = memorySize;
+		}
+
+		for(i = 0; i < size; i += length, data += length)
+		{
+			length = size - i;
+
+			if(length > writer->recordLength)
+				length = writer->recordLength;
+
+			if(writeHexRecordToHexFile(writer, INTEL_HEX_RECORD_DATA, length, offset + i, data) != 0)
+			{
+				ERROR("failed to write data record to hex file\n");
+				return -1;
+			}
+		}
+
+		address += size;
+		memorySize -= size;
+	}
+
+	return 0;
+}
+
+static int writeBytesToBinFile(IntelHexWriter *writer, const uint8_t *data, uint64_t size)
+{
+	if(size <= (WRITER_BUFFER_SIZE - writer->size))
+	{
+		memcpy(&writer->buffer[writer->size], data, size);
+		writer->size += size;
+	}
+	else if(flushWriter(writer) != 0 || fwrite(data, 1, size, writer->file) != size)
+	{
+		ERROR("failed to write %llu bytes of data to bin file\n", (unsigned long long)size);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int writeDataToBinFile(IntelHexWriter *writer, uint32_t baseAddress, const uint8_t *data, uint64_t size)
+{
+	if(writeValueToBinFile(writer, baseAddress) != 0 || writeValueToBinFile(writer, (uint32_t)size) != 0)
+	{
+		ERROR("failed to write data base address and size info to bin file\n");
+		return -1;
+	}
+
+	return writeBytesToBinFile(writer, data, size);
+}
+
+static int stopWriting(IntelHexWriter *writer)
+{
+	int status = 0;
+
+	if(writer->buffer == NULL)
+		return -1;
+
+	if(writer->format == INTEL_HEX_FORMAT_HEX && writeHexRecordToHexFile(writer, INTEL_HEX_RECORD_END_OF_FILE, 0, 0, NULL) != 0)
+	{
+		ERROR("failed to write end-of-file record to hex file\n");
+		status = -1;
+	}
+
+	if(status == 0)
+		status = flushWriter(writer);
+
+	free(writer->buffer);
+	writer->buffer = NULL;
+
+	return status;
+}
+
+static int writeHexInfoToFile(IntelHex *hex, int format, FILE *file, uint32_t flags)
+{
+	IntelHexWriter writer;
+	IntelHexMemory *memory;
+	int status;
+
+	status = startWriting(&writer, format, file, hex->eip, hex->cs, hex->ip, hex->endAddress, flags);
+
+	for(memory = hex->memory; memory != NULL && status == 0; memory = memory->next)
+		status = intelHex_writeData(&writer, memory->baseAddress, memory->data, getMemorySize(memory));
+
+	if(stopWriting(&writer) != 0)
+		status = -1;
+
+	return status;
+}
+
+int intelHex_openWriter(IntelHexWriter *writer, int format, const char *filename, uint32_t lastAddress, uint32_t flags)
+{
+	IntelHex hex;
+	FILE *file;
+
+	if(writer == NULL)
+		return -1;
+
+	writer->buffer = NULL;
+	writer->file = NULL;
+
+	if(format != INTEL_HEX_FORMAT_HEX && format != INTEL_HEX_FORMAT_BIN)
+	{
+		ERROR("only hex and bin files can be written with a writer\n");
+		return -1;
+	}
+
+	intelHex_initializeHexInfo(&hex, flags);
+
+	if(lastAddress > hex.endmostAddress)
+	{
+		ERROR("last address, 0x%.8x, exceeded the maximum address of 0x%.8x\n", lastAddress, hex.endmostAddress);
+		return -1;
+	}
+
+	if((file = fopen(filename, (format == INTEL_HEX_FORMAT_HEX) ? "w" : "wb")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for writing\n", filename);
+		return -1;
+	}
+
+	if(startWriting(writer, format, file, INTEL_HEX_INVALID_ADDRESS, INTEL_HEX_INVALID_ADDRESS, INTEL_HEX_INVALID_ADDRESS, getEndAddress(hex.endAddress, lastAddress), flags) != 0)
+	{
+		intelHex_closeWriter(writer);
+		return -1;
+	}
+
+	return 0;
+}
+
+int intelHex_writeData(IntelHexWriter *writer, uint32_t baseAddress, const uint8_t *data, uint64_t size)
+{
+	if(writer == NULL || writer->buffer == NULL || data == NULL)
+		return -1;
+
+	if(size < 1 || baseAddress > writer->endAddress || (size - 1) > (writer->endAddress - baseAddress))
+	{
+		ERROR("data at 0x%.8x with %llu bytes does not fit the addressing\n", baseAddress, (unsigned long long)size);
+		return -1;
+	}
+
+	if(writer->format == INTEL_HEX_FORMAT_HEX)
+		return writeDataToHexFile(writer, baseAddress, data, size);
+
+	return writeDataToBinFile(writer, baseAddress, data, size);
+}
+
+int intelHex_closeWriter(IntelHexWriter *writer)
+{
+	int status = -1;
+
+	if(writer == NULL)
+		return -1;
+
+	if(writer->buffer != NULL)
+		status = stopWriting(writer);
+
+	if(writer->file != NULL)
+	{
+		if(fclose(writer->file) != 0)
+			status = -1;
+
+		writer->file = NULL;
+	}
+
+	return status;
+}
+
+/******************************************************************************
+ * digests
+ */
+
+#define CRC16_POLYNOMIAL	0x8005
+
+#define PRIME64_1			0x9e3779b185ebca87ULL
+#define PRIME64_2			0xc2b2ae3d27d4eb4fULL
+#define PRIME64_3			0x165667b19e3779f9ULL
+#define PRIME64_4			0x85ebca77c2b2ae63ULL
+#define PRIME64_5			0x27d4eb2f165667c5ULL
+
+static uint16_t crc16Table[8][256];
+static pthread_once_t crc16TableOnce = PTHREAD_ONCE_INIT;
+
+static void initializeCrc16Table(void)
+{
+	uint32_t crc;
+	int i;
+	int j;
+
+	/**
+	 * note: crc16Table[k][byte] is the CRC of byte followed by k zero bytes,
+	 *       so 8 bytes are folded in with 8 lookups (slice-by-8)
+	 */
+
+	for(i = 0; i < 256; i++)
+	{
+		crc = i << 8;
+
+		for(j = 0; j < 8; j++)
+			crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_POLYNOMIAL) : (crc << 1);
+
+		crc16Table[0][i] = (uint16_t)crc;
+	}
+
+	for(i = 0; i < 256; i++)
+	{
+		for(j = 1; j < 8; j++)
+			crc16Table[j][i] = (crc16Table[j - 1][i] << 8) ^ crc16Table[0][crc16Table[j - 1][i] >> 8];
+	}
+}
+
+static inline uint64_t getLittleEndianValue(const uint8_t *data, int size)
+{
+	uint64_t value = 0;
+
+	while(size-- > 0)
+		value = (value << 8) | data[size];
+
+	return value;
+}
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t hashRound(uint64_t accumulator, uint64_t value)
+{
+	return rotateLeft(accumulator + (value * PRIME64_2), 31) * PRIME64_1;
+}
+
+static inline uint64_t mergeHashRound(uint64_t accumulator, uint64_t value)
+{
+	return ((accumulator ^ hashRound(0, value)) * PRIME64_1) + PRIME64_4;
+}
+
+uint16_t intelHex_crc16(uint16_t crc, const uint8_t *data, uint64_t size)
+{
+	pthread_once(&crc16TableOnce, initializeCrc16Table);
+
+	for(; size >= 8; size -= 8, data += 8)
+	{
+		crc = crc16Table[7][data[0] ^ (crc >> 8)] ^ crc16Table[6][data[1] ^ (crc & 0xff)] ^
+				crc16Table[5][data[2]] ^ crc16Table[4][data[3]] ^ crc16Table[3][data[4]] ^
+				crc16Table[2][data[5]] ^ crc16Table[1][data[6]] ^ crc16Table[0][data[7]];
+	}
+
+	for(; size > 0; size--, data++)
+		crc = (crc << 8) ^ crc16Table[0][*data ^ (crc >> 8)];
+
+	return crc;
+}
+
+uint64_t intelHex_hash64(uint64_t seed, const uint8_t *data, uint64_t size)
+{
+	const uint8_t *end = data + size;
+	uint64_t accumulators[4];
+	uint64_t hash;
+	int i;
+
+	/**
+	 * note: XXH64, so digests can be checked with the xxhsum tool
+	 */
+
+	if(size >= 32)
+	{
+		accumulators[0] = seed + PRIME64_1 + PRIME64_2;
+		accumulators[1] = seed + PRIME64_2;
+		accumulators[2] = seed;
+		accumulators[3] = seed - PRIME64_1;
+
+		for(; (end - data) >= 32; data += 32)
+		{
+			for(i = 0; i < 4; i++)
+				accumulators[i] = hashRound(accumulators[i], getLittleEndianValue(&data[i * 8], 8));
+		}
+
+		hash = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) + rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18);
+
+		for(i = 0; i < 4; i++)
+			hash = mergeHashRound(hash, accumulators[i]);
+	}
+	else
+		hash = seed + PRIME64_5;
+
+	hash += size;
+
+	for(; (end - data) >= 8; data += 8)
+		hash = (rotateLeft(hash ^ hashRound(0, getLittleEndianValue(data, 8)), 27) * PRIME64_1) + PRIME64_4;
+
+	if((end - data) >= 4)
+	{
+		hash = (rotateLeft(hash ^ (getLittleEndianValue(data, 4) * PRIME64_1), 23) * PRIME64_2) + PRIME64_3;
+		data += 4;
+	}
+
+	for(; data < end; data++)
+		hash = rotateLeft(hash ^ (*data * PRIME64_5), 11) * PRIME64_1;
+
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+/**
+ * reader of the pages with data in hex info structure, in address order
+ */
+typedef struct {
+	const IntelHexMemory *memory;	/* first region that ends after the page */
+	uint32_t pageSize;
+	uint64_t pageAddress;
+	uint64_t pageEndAddress;
+	uint8_t *buffer;				/* page put together from pieces */
+	int isPartial;					/* page has bytes without data */
+} PageReader;
+
+static int startReadingPages(PageReader *reader, const IntelHex *hex, uint32_t pageSize)
+{
+	reader->memory = hex->memory;
+	reader->pageSize = pageSize;
+	reader->pageAddress = 0;
+	reader->pageEndAddress = 0;
+	reader->isPartial = 0;
+
+	if((reader->buffer = (uint8_t *)malloc(pageSize)) == NULL)
+	{
+		ERROR("failed to allocate memory for page buffer\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static const uint8_t * readNextPage(PageReader *reader)
+{
+	const IntelHexMemory *memory = reader->memory;
+	const uint8_t *data;
+	uint64_t startAddress;
+	uint64_t endAddress;
+	uint64_t size = 0;
+
+	/**
+	 * note: pages with data from more than one region, or with gaps, are put
+	 *       together in buffer, with 0xff for the gaps as in erased flash
+	 */
+
+	if(memory == NULL)
+		return NULL;
+
+	if((reader->pageAddress = ((uint64_t)memory->baseAddress / reader->pageSize) * reader->pageSize) < reader->pageEndAddress)
+		reader->pageAddress = reader->pageEndAddress;
+
+	reader->pageEndAddress = reader->pageAddress + reader->pageSize;
+
+	if(memory->baseAddress <= reader->pageAddress && (memory->baseAddress + getMemorySize(memory)) >= reader->pageEndAddress)
+	{
+		data = &memory->data[reader->pageAddress - memory->baseAddress];
+		size = reader->pageSize;
+	}
+	else
+	{
+		memset(reader->buffer, 0xff, reader->pageSize);
+
+		for(; memory != NULL && memory->baseAddress < reader->pageEndAddress; memory = memory->next)
+		{
+			startAddress = (memory->baseAddress > reader->pageAddress) ? memory->baseAddress : reader->pageAddress;
+
+			if((endAddress = memory->baseAddress + getMemorySize(memory)) > reader->pageEndAddress)
+				endAddress = reader->pageEndAddress;
+
+			memcpy(&reader->buffer[startAddress - reader->pageAddress], &memory->data[startAddress - memory->baseAddress], endAddress - startAddress);
+			size += endAddress - startAddress;
+		}
+
+		data = reader->buffer;
+	}
+
+	reader->isPartial = (size < reader->pageSize);
+
+	while(reader->memory != NULL && ((uint64_t)reader->memory->baseAddress + getMemorySize(reader->memory)) <= reader->pageEndAddress)
+		reader->memory = reader->memory->next;
+
+	return data;
+}
+
+static inline void stopReadingPages(PageReader *reader)
+{
+	free(reader->buffer);
+	reader->buffer = NULL;
+}
+
+static void getPageDigest(IntelHexDigest *digest, IntelHexDigest *imageDigest, uint32_t page, const uint8_t *data, uint32_t pageSize)
+{
+	uint8_t hash[8];
+	int i;
+
+	digest->page = page;
+	digest->crc = intelHex_crc16(INTEL_HEX_CRC16_SEED, data, pageSize);
+	digest->hash = intelHex_hash64(0, data, pageSize);
+
+	imageDigest->page++;
+	imageDigest->crc = intelHex_crc16(imageDigest->crc, data, pageSize);
+
+	for(i = 0; i < 8; i++)
+		hash[i] = (digest->hash >> (i * 8)) & 0xff;
+
+	imageDigest->hash = intelHex_hash64(imageDigest->hash, hash, sizeof(hash));
+}
+
+static inline void initializeImageDigest(IntelHexDigest *imageDigest)
+{
+	imageDigest->page = 0;
+	imageDigest->crc = INTEL_HEX_CRC16_SEED;
+	imageDigest->hash = 0;
+}
+
+int intelHex_getDigests(const IntelHex *hex, uint32_t pageSize, IntelHexDigest **digests, uint32_t *numberOfDigests, IntelHexDigest *imageDigest)
+{
+	PageReader reader;
+	IntelHexDigest *digest;
+	const uint8_t *data;
+	uint32_t capacity = 0;
+
+	if(hex == NULL || pageSize < 1 || digests == NULL || numberOfDigests == NULL || imageDigest == NULL)
+	{
+		ERROR("hex info structure, digests, and page size cannot be NULL or 0\n");
+		return -1;
+	}
+
+	*digests = NULL;
+	*numberOfDigests = 0;
+	initializeImageDigest(imageDigest);
+
+	if(startReadingPages(&reader, hex, pageSize) != 0)
+		return -1;
+
+	while((data = readNextPage(&reader)) != NULL)
+	{
+		if(*numberOfDigests == capacity)
+		{
+			capacity = (capacity == 0) ? 16 : (capacity * 2);
+
+			if((digest = (IntelHexDigest *)realloc(*digests, capacity * sizeof(IntelHexDigest))) == NULL)
+			{
+				ERROR("failed to allocate memory for digests\n");
+				stopReadingPages(&reader);
+				free(*digests);
+				*digests = NULL;
+				*numberOfDigests = 0;
+				return -1;
+			}
+
+			*digests = digest;
+		}
+
+		getPageDigest(&(*digests)[(*numberOfDigests)++], imageDigest, (uint32_t)(reader.pageAddress / pageSize), data, pageSize);
+	}
+
+	stopReadingPages(&reader);
+	return 0;
+}
+
+/******************************************************************************
+ * image files
+ */
+
+#define IMAGE_MAGIC					"IHXI"
+#define IMAGE_VERSION				1
+#define IMAGE_HEADER_SIZE			64
+#define IMAGE_PAGE_ENTRY_SIZE		8
+#define IMAGE_ALIGNMENT				4096
+#define IMAGE_MAXIMUM_PAGE_SHIFT	15
+#define IMAGE_NO_PAYLOAD			0xffffffff
+
+static inline void setLittleEndianValue(uint8_t *data, uint64_t value, int size)
+{
+	while(size-- > 0)
+	{
+		*data++ = value & 0xff;
+		value >>= 8;
+	}
+}
+
+static inline int isBlankPage(const uint8_t *data, uint32_t pageSize)
+{
+	return (data[0] == 0xff && memcmp(data, &data[1], pageSize - 1) == 0);
+}
+
+static int writeImageToFile(const IntelHex *hex, FILE *file, uint32_t flags)
+{
+	PageReader reader;
+	IntelHexDigest digest;
+	IntelHexDigest imageDigest;
+	const IntelHexMemory *memory;
+	const uint8_t *data;
+	uint8_t *header;
+	uint8_t *entry;
+	uint64_t firstPage = 0;
+	uint64_t numberOfPages = 0;
+	uint64_t payloadOffset;
+	uint64_t alignment;
+	uint64_t index;
+	uint32_t numberOfPayloads = 0;
+	uint32_t pageSize;
+	uint32_t pageFlags;
+	int status = 0;
+
+	if(INTEL_HEX_FLAGS_PAGE_SHIFT(flags) > IMAGE_MAXIMUM_PAGE_SHIFT)
+	{
+		ERROR("page size of image file should never be greater than %u bytes\n", 1 << IMAGE_MAXIMUM_PAGE_SHIFT);
+		return -1;
+	}
+
+	pageSize = (INTEL_HEX_FLAGS_PAGE_SHIFT(flags) == 0) ? INTEL_HEX_DEFAULT_PAGE_SIZE : (1 << INTEL_HEX_FLAGS_PAGE_SHIFT(flags));
+
+	if(hex->memory != NULL)
+	{
+		for(memory = hex->memory; memory->next != NULL; memory = memory->next);
+
+		firstPage = hex->memory->baseAddress / pageSize;
+		numberOfPages = ((memory->baseAddress + getMemorySize(memory) - 1) / pageSize) - firstPage + 1;
+	}
+
+	alignment = (pageSize > IMAGE_ALIGNMENT) ? pageSize : IMAGE_ALIGNMENT;
+	payloadOffset = IMAGE_HEADER_SIZE + ((numberOfPages + 7) / 8) + (numberOfPages * IMAGE_PAGE_ENTRY_SIZE);
+	payloadOffset = ((payloadOffset + alignment - 1) / alignment) * alignment;
+
+	/**
+	 * note: header and tables are filled in a first pass over the pages, as
+	 *       they come before the payloads; a second pass writes the payloads
+	 */
+
+	if((header = (uint8_t *)calloc(1, payloadOffset)) == NULL)
+	{
+		ERROR("failed to allocate memory for image file header\n");
+		return -1;
+	}
+
+	for(index = 0, entry = &header[IMAGE_HEADER_SIZE + ((numberOfPages + 7) / 8)]; index < numberOfPages; index++, entry += IMAGE_PAGE_ENTRY_SIZE)
+		setLittleEndianValue(&entry[4], IMAGE_NO_PAYLOAD, 4);
+
+	initializeImageDigest(&imageDigest);
+
+	if(startReadingPages(&reader, hex, pageSize) != 0)
+	{
+		free(header);
+		return -1;
+	}
+
+	while((data = readNextPage(&reader)) != NULL)
+	{
+		index = (reader.pageAddress / pageSize) - firstPage;
+		entry = &header[IMAGE_HEADER_SIZE + ((numberOfPages + 7) / 8) + (index * IMAGE_PAGE_ENTRY_SIZE)];
+
+		getPageDigest(&digest, &imageDigest, (uint32_t)(reader.pageAddress / pageSize), data, pageSize);
+
+		pageFlags = reader.isPartial ? INTEL_HEX_PAGE_PARTIAL : 0;
+
+		if(isBlankPage(data, pageSize))
+			pageFlags |= INTEL_HEX_PAGE_BLANK;
+		else
+			setLittleEndianValue(&entry[4], numberOfPayloads++, 4);
+
+		header[IMAGE_HEADER_SIZE + (index / 8)] |= 1 << (index % 8);
+		setLittleEndianValue(&entry[0], digest.crc, 2);
+		setLittleEndianValue(&entry[2], pageFlags, 2);
+	}
+
+	memcpy(header, IMAGE_MAGIC, 4);
+	setLittleEndianValue(&header[4], IMAGE_VERSION, 4);
+	setLittleEndianValue(&header[8], IMAGE_HEADER_SIZE, 4);
+	setLittleEndianValue(&header[12], hex->eip, 4);
+	setLittleEndianValue(&header[16], hex->cs, 4);
+	setLittleEndianValue(&header[20], hex->ip, 4);
+	setLittleEndianValue(&header[24], INTEL_HEX_FLAGS_CHIP_ID(flags), 4);
+	setLittleEndianValue(&header[28], pageSize, 4);
+	setLittleEndianValue(&header[32], firstPage, 4);
+	setLittleEndianValue(&header[36], numberOfPages, 4);
+	setLittleEndianValue(&header[40], numberOfPayloads, 4);
+	setLittleEndianValue(&header[44], payloadOffset, 4);
+	setLittleEndianValue(&header[48], imageDigest.page, 4);
+	setLittleEndianValue(&header[52], imageDigest.crc, 4);
+	setLittleEndianValue(&header[56], imageDigest.hash, 8);
+
+	if(fwrite(header, 1, payloadOffset, file) != payloadOffset)
+	{
+		ERROR("failed to write header of image file\n");
+		status = -1;
+	}
+
+	stopReadingPages(&reader);
+	startReadingPages(&reader, hex, pageSize);
+
+	while(status == 0 && (data = readNextPage(&reader)) != NULL)
+	{
+		index = (reader.pageAddress / pageSize) - firstPage;
+		entry = &header[IMAGE_HEADER_SIZE + ((numberOfPages + 7) / 8) + (index * IMAGE_PAGE_ENTRY_SIZE)];
+
+		if(!(entry[2] & INTEL_HEX_PAGE_BLANK) && fwrite(data, 1, pageSize, file) != pageSize)
+		{
+			ERROR("failed to write page %llu to image file\n", (unsigned long long)(reader.pageAddress / pageSize));
+			status = -1;
+		}
+	}
+
+	stopReadingPages(&reader);
+	free(header);
+
+	return status;
+}
+
+static int mapImageFile(FILE *file, IntelHexImage *image)
+{
+	const uint8_t *data;
+	uint64_t headerSize;
+	uint64_t mapSize;
+	uint64_t payloadOffset;
+
+	memset(image, 0, sizeof(IntelHexImage));
+
+	if((data = (const uint8_t *)mapFile(file, &image->mappingSize)) == NULL)
+	{
+		ERROR("failed to map image file; it must be a regular file\n");
+		return -1;
+	}
+
+	image->mapping = (void *)data;
+
+	if(image->mappingSize < IMAGE_HEADER_SIZE || memcmp(data, IMAGE_MAGIC, 4) != 0)
+	{
+		ERROR("image file header not found\n");
+		intelHex_closeImage(image);
+		return -1;
+	}
+
+	if(getLittleEndianValue(&data[4], 4) != IMAGE_VERSION)
+	{
+		ERROR("image file version %u is not supported\n", (uint32_t)getLittleEndianValue(&data[4], 4));
+		intelHex_closeImage(image);
+		return -1;
+	}
+
+	headerSize = getLittleEndianValue(&data[8], 4);
+	image->eip = getLittleEndianValue(&data[12], 4);
+	image->cs = getLittleEndianValue(&data[16], 4);
+	image->ip = getLittleEndianValue(&data[20], 4);
+	image->chipId = getLittleEndianValue(&data[24], 4);
+	image->pageSize = getLittleEndianValue(&data[28], 4);
+	image->firstPage = getLittleEndianValue(&data[32], 4);
+	image->numberOfPages = getLittleEndianValue(&data[36], 4);
+	image->numberOfPayloads = getLittleEndianValue(&data[40], 4);
+	payloadOffset = getLittleEndianValue(&data[44], 4);
+	image->digest.page = getLittleEndianValue(&data[48], 4);
+	image->digest.crc = getLittleEndianValue(&data[52], 2);
+	image->digest.hash = getLittleEndianValue(&data[56], 8);
+
+	mapSize = ((uint64_t)image->numberOfPages + 7) / 8;
+
+	if(checkEip(image->eip) != 0 || checkCsAndIp(image->cs, image->ip) != 0)
+	{
+		intelHex_closeImage(image);
+		return -1;
+	}
+
+	if(image->pageSize < 1 || ((uint64_t)image->firstPage + image->numberOfPages) * image->pageSize > 0x100000000ULL)
+	{
+		ERROR("pages of image file exceeded the maximum address of 0x%.8x\n", MAX_32BIT);
+		intelHex_closeImage(image);
+		return -1;
+	}
+
+	if(headerSize < IMAGE_HEADER_SIZE || (headerSize + mapSize + ((uint64_t)image->numberOfPages * IMAGE_PAGE_ENTRY_SIZE)) > payloadOffset ||
+			payloadOffset > image->mappingSize || ((uint64_t)image->numberOfPayloads * image->pageSize) > (image->mappingSize - payloadOffset))
+	{
+		ERROR("image file of %llu bytes is too short for its page map, page entries, and payloads\n", (unsigned long long)image->mappingSize);
+		intelHex_closeImage(image);
+		return -1;
+	}
+
+	image->pageMap = &data[headerSize];
+	image->pageEntries = &data[headerSize + mapSize];
+	image->payloads = &data[payloadOffset];
+
+	return 0;
+}
+
+static int readHexInfoFromImageFile(FILE *file, IntelHex *hex, uint32_t flags)
+{
+	IntelHexImage image;
+	IntelHexPage imagePage;
+	const uint8_t *data = NULL;
+	uint8_t *blankPage = NULL;
+	uint64_t address = 0;
+	uint64_t size = 0;
+	uint32_t page;
+	int status = 0;
+	int result;
+
+	/**
+	 * note: runs of pages with payloads one after another are used in place,
+	 *       so the mapping stays until hex is destroyed
+	 */
+
+	intelHex_initializeHexInfo(hex, flags);
+
+	if(mapImageFile(file, &image) != 0)
+		return -1;
+
+	hex->mapping = image.mapping;
+	hex->mappingSize = image.mappingSize;
+	hex->eip = image.eip;
+	hex->cs = image.cs;
+	hex->ip = image.ip;
+
+	for(page = image.firstPage; status == 0 && (page - image.firstPage) < image.numberOfPages; page++)
+	{
+		if((result = intelHex_getImagePage(&image, page, &imagePage)) != 0)
+		{
+			status = (result < 0) ? -1 : 0;
+			continue;
+		}
+
+		if(size > 0 && (imagePage.data == NULL || imagePage.data != &data[size] || ((uint64_t)page * image.pageSize) != (address + size)))
+		{
+			status = saveDataToHexInfo(hex, data, NULL, size, (uint32_t)address, 1);
+			size = 0;
+		}
+
+		if(imagePage.data != NULL)
+		{
+			if(size == 0)
+			{
+				data = imagePage.data;
+				address = (uint64_t)page * image.pageSize;
+			}
+
+			size += image.pageSize;
+		}
+		else if(status == 0)
+		{
+			if(blankPage == NULL && (blankPage = (uint8_t *)malloc(image.pageSize)) == NULL)
+			{
+				ERROR("failed to allocate memory for blank page\n");
+				status = -1;
+				break;
+			}
+
+			memset(blankPage, 0xff, image.pageSize);
+			status = saveDataToHexInfo(hex, blankPage, NULL, image.pageSize, page * image.pageSize, 0);
+		}
+	}
+
+	if(status == 0 && size > 0)
+		status = saveDataToHexInfo(hex, data, NULL, size, (uint32_t)address, 1);
+
+	if(blankPage != NULL)
+		free(blankPage);
+
+	return status;
+}
+
+int intelHex_openImage(const char *filename, IntelHexImage *image)
+{
+	FILE *file;
+	int status;
+
+	if(filename == NULL || image == NULL)
+	{
+		ERROR("filename and image cannot be NULL\n");
+		return -1;
+	}
+
+	if((file = fopen(filename, "rb")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for reading\n", filename);
+		return -1;
+	}
+
+	status = mapImageFile(file, image);
+
+	fclose(file);
+	return status;
+}
+
+int intelHex_getImagePage(const IntelHexImage *image, uint32_t page, IntelHexPage *imagePage)
+{
+	const uint8_t *entry;
+	uint32_t index;
+	uint32_t payload;
+
+	if(image == NULL || image->mapping == NULL || imagePage == NULL)
+	{
+		ERROR("image and page cannot be NULL\n");
+		return -1;
+	}
+
+	if(page < image->firstPage || (index = page - image->firstPage) >= image->numberOfPages || !(image->pageMap[index / 8] & (1 << (index % 8))))
+		return 1;
+
+	entry = &image->pageEntries[(uint64_t)index * IMAGE_PAGE_ENTRY_SIZE];
+	payload = getLittleEndianValue(&entry[4], 4);
+
+	imagePage->page = page;
+	imagePage->crc = getLittleEndianValue(&entry[0], 2);
+	imagePage->flags = getLittleEndianValue(&entry[2], 2);
+	imagePage->data = NULL;
+
+	if(!(imagePage->flags & INTEL_HEX_PAGE_BLANK))
+	{
+		if(payload >= image->numberOfPayloads)
+		{
+			ERROR("page %u of image file has no payload\n", page);
+			return -1;
+		}
+
+		imagePage->data = &image->payloads[(uint64_t)payload * image->pageSize];
+	}
+
+	return 0;
+}
+
+void intelHex_closeImage(IntelHexImage *image)
+{
+	if(image == NULL)
+		return;
+
+	if(image->mapping != NULL)
+		munmap(image->mapping, image->mappingSize);
+
+	image->mapping = NULL;
+	image->mappingSize = 0;
+}
+
+/******************************************************************************
+ * conversion
+ */
+
+int intelHex_convert(int inputFormat, const char *inputFilename, const IntelHex *inputHex, int outputFormat, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
+{
+	int status = -1;
+	FILE *inputFile;
+	FILE *outputFile;
+	IntelHex hex;
+
+	if((inputFilename == NULL && inputHex == NULL) || (inputFilename != NULL && inputHex != NULL))
+	{
+		ERROR("at most one of inputFilename and inputHex must be specified\n");
+		return -1;
+	}
+
+	if(outputFilename == NULL && outputHex == NULL)
+	{
+		ERROR("at least one of outputFilename and outputHex must be specified\n");
+		return -1;
+	}
+
+	if(openFiles(&inputFile, inputFilename, (inputFormat == INTEL_HEX_FORMAT_HEX) ? "r" : "rb", &outputFile, outputFilename, (outputFormat == INTEL_HEX_FORMAT_HEX) ? "w" : "wb") != 0)
+		return -1;
+
+	if(outputHex == NULL)
+		outputHex = &hex;
+
+	if(inputFile == NULL)
+		status = copyHexInfo(inputHex, outputHex, flags);
+	else
+	{
+		if(inputFormat == INTEL_HEX_FORMAT_HEX)
+			status = readHexInfoFromMappedHexFile(inputFile, outputHex, flags, 0, NULL, NULL);
+		else if(inputFormat == INTEL_HEX_FORMAT_IMAGE)
+			status = readHexInfoFromImageFile(inputFile, outputHex, flags);
+		else
+			status = readHexInfoFromMappedBinFile(inputFile, outputHex, flags);
+
+		fclose(inputFile);
+	}
+
+	if(outputFile != NULL)
+	{
+		if(status == 0)
+		{
+			if(outputFormat == INTEL_HEX_FORMAT_IMAGE)
+				status = writeImageToFile(outputHex, outputFile, flags);
+			else
+				status = writeHexInfoToFile(outputHex, outputFormat, outputFile, flags);
+		}
+
+		fclose(outputFile);
+	}
+
+	if(status != 0 || outputHex == &hex)
+		intelHex_destroyHexInfo(outputHex);
+
+	return status;
+}
+
+int intelHex_streamHexFile(const char *filename, uint32_t flags, IntelHexDataHandler handler, void *context)
+{
+	IntelHex hex;
+	FILE *file;
+	int status;
+
+	if(filename == NULL || handler == NULL)
+	{
+		ERROR("filename and handler cannot be NULL\n");
+		return -1;
+	}
+
+	if((file = fopen(filename, "r")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for reading\n", filename);
+		return -1;
+	}
+
+	status = readHexInfoFromMappedHexFile(file, &hex, flags, 1, handler, context);
+
+	fclose(file);
+	intelHex_destroyHexInfo(&hex);
+
+	return status;
+}
+
+int intelHex_readRawFile(const char *filename, uint64_t offset, uint64_t size, uint32_t baseAddress, IntelHex *hex, uint32_t flags)
+{
+	uint8_t *data;
+	uint64_t length;
+	FILE *file;
+	long fileSize;
+	int status = -1;
+
+	if(filename == NULL || hex == NULL)
+	{
+		ERROR("filename and hex info structure cannot be NULL\n");
+		return -1;
+	}
+
+	intelHex_initializeHexInfo(hex, flags);
+
+	if((file = fopen(filename, "rb")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for reading\n", filename);
+		return -1;
+	}
+
+	if((data = (uint8_t *)mapFile(file, &length)) != NULL)
+	{
+		hex->mapping = data;
+		hex->mappingSize = length;
+	}
+	else if(fseek(file, 0, SEEK_END) == 0 && (fileSize = ftell(file)) >= 0)
+		length = fileSize;
+	else
+	{
+		ERROR("failed to get the size of raw file\n");
+		fclose(file);
+		return -1;
+	}
+
+	if(offset >= length || size > (length - offset))
+		ERROR("raw file of %llu bytes has no data at offset %llu with %llu bytes\n", (unsigned long long)length, (unsigned long long)offset, (unsigned long long)size);
+	else if(data != NULL)
+		status = saveDataToHexInfo(hex, &data[offset], NULL, (size == 0) ? (length - offset) : size, baseAddress, 1);
+	else if(fseek(file, offset, SEEK_SET) != 0)
+		ERROR("failed to set the position indicator of raw file\n");
+	else
+		status = saveDataToHexInfo(hex, NULL, file, (size == 0) ? (length - offset) : size, baseAddress, 0);
+
+	fclose(file);
+	return status;
+}
+
+inline int intelHex_hexToBin(const char *inputFilename, const IntelHex *inputHex, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
+{
+	return intelHex_convert(INTEL_HEX_FORMAT_HEX, inputFilename, inputHex, INTEL_HEX_FORMAT_BIN, outputFilename, outputHex, flags);
+}
+
+inline int intelHex_binToHex(const char *inputFilename, const IntelHex *inputHex, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
+{
+	return intelHex_convert(INTEL_HEX_FORMAT_BIN, inputFilename, inputHex, INTEL_HEX_FORMAT_HEX, outputFilename, outputHex, flags);
+}
+
+#ifdef INTELHEX_STANDALONE
+
+#include <time.h>
+
+#define STREAM_BUFFER_SIZE		0x10000
+#define DIGEST_PAGE_SIZE		2048
+
+/**
+ * streaming conversion
+ *
+ * note: data goes to the output file as it is read, through a window of at
+ *       most one block of data records, i.e. up to the next 64K boundary of
+ *       the hex writer, so hex files come out the same as from memory; bin
+ *       files get the size of each memory chunk written when it ends
+ */
+typedef struct {
+	IntelHex hex;				/* EIP, CS, and IP, and the addressing of input */
+	IntelHexWriter writer;
+	uint8_t *window;			/* data waiting for the end of its block */
+	uint32_t windowAddress;
+	uint32_t windowSize;
+	uint32_t blockMask;			/* a block ends where (address & blockMask) is 0 */
+	uint64_t nextAddress;		/* end of the data so far */
+	uint32_t lastAddress;
+	int hasData;
+	int isInOrder;
+	long chunkSizePosition;		/* of the size of the current memory chunk in bin file */
+	uint64_t chunkSize;
+	uint32_t numberOfRegions;
+	uint64_t bytes;
+} StreamConverter;
+
+static void usage(const char *name)
+{
+	ERROR("wrong parameter\n");
+
+	printf(PREFIX "usage:\n"
+			"  \n"
+			"  %s <input file format: \"-hex\", \"-bin\", or \"-img\"> <input file> <output file format: \"-hex\", \"-bin\", or \"-img\"> <output file> [optional parameters]\n"
+			"  \n"
+			"  [optional parameters]\n"
+			"    -rl<[0 to 255]>, to specify the maximum data record length; 0 to 255 bytes\n"
+			"    -ur, to allow unknown record\n"
+			"    -ad<[8,16,32]>, to force the addressing\n"
+			"    -st, to stream the data from input file to output file, without loading it in memory;\n"
+			"         files with data out of order are still loaded in memory\n"
+			"    -id<[0 to 255]>, to specify the chip ID of an image output file; 0, any chip, by default\n"
+			"    -ps<[2 to 32768]>, to specify the page size of an image output file, a power of 2; %d bytes by default\n"
+			"  \n"
+			"  %s -bench <hex file> [iterations]\n"
+			"  \n"
+			"    to compare the stdio, mmap, and parallel hex readers; 10 iterations by default\n"
+			"  \n"
+			"  %s -digest <input file format: \"-hex\", \"-bin\", or \"-img\"> <input file> [page size]\n"
+			"  \n"
+			"    to print CRC16 and 64-bit hash of each page with data, and of the whole image;\n"
+			"    %d-byte pages by default\n"
+			"  \n",
+			name, INTEL_HEX_DEFAULT_PAGE_SIZE, name, name, DIGEST_PAGE_SIZE);
+}
+
+static int getFileFormat(const char *option)
+{
+	if(strcmp(option, "-hex") == 0)
+		return INTEL_HEX_FORMAT_HEX;
+
+	if(strcmp(option, "-bin") == 0)
+		return INTEL_HEX_FORMAT_BIN;
+
+	if(strcmp(option, "-img") == 0)
+		return INTEL_HEX_FORMAT_IMAGE;
+
+	return -1;
+}
+
+static const char * getFileFormatName(int format)
+{
+	return (format == INTEL_HEX_FORMAT_HEX) ? "hex" : ((format == INTEL_HEX_FORMAT_BIN) ? "bin" : "image");
+}
+
+static int getDecimalValue(const char *data, int maxDigits)
+{
+	int value = 0;
+	int multiplier = 1;
+	int i = strlen(data);
+
+	if(i < 1 || i > maxDigits || (i > 1 && *data == '0'))
+		return -1;
+
+	while(i-- > 0)
+	{
+		if(!isdigit(data[i]))
+			return -1;
+
+		value += ((data[i] - '0') * multiplier);
+		multiplier *= 10;
+	}
+
+	return value;
+}
+
+static double getSeconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+static int isSameHexInfo(const IntelHex *hex0, const IntelHex *hex1)
+{
+	const IntelHexMemory *memory0;
+	const IntelHexMemory *memory1;
+
+	if(hex0->eip != hex1->eip || hex0->cs != hex1->cs || hex0->ip != hex1->ip || hex0->endAddress != hex1->endAddress)
+		return 0;
+
+	for(memory0 = hex0->memory, memory1 = hex1->memory; memory0 != NULL && memory1 != NULL; memory0 = memory0->next, memory1 = memory1->next)
+	{
+		if(memory0->baseAddress != memory1->baseAddress || memory0->size != memory1->size || memcmp(memory0->data, memory1->data, getMemorySize(memory0)) != 0)
+			return 0;
+	}
+
+	return (memory0 == NULL && memory1 == NULL);
+}
+
+static int readMappedHexFileSerially(FILE *file, IntelHex *hex, uint32_t flags)
+{
+	return readHexInfoFromMappedHexFile(file, hex, flags, 1, NULL, NULL);
+}
+
+static int readMappedHexFileInParallel(FILE *file, IntelHex *hex, uint32_t flags)
+{
+	return readHexInfoFromMappedHexFile(file, hex, flags, 0, NULL, NULL);
+}
+
+static int benchmark(const char *filename, int iterations)
+{
+	static int (* const readers[])(FILE *, IntelHex *, uint32_t) = { readHexInfoFromHexFile, readMappedHexFileSerially, readMappedHexFileInParallel };
+	static const char * const readerNames[] = { "stdio", "mmap", "mmap, in parallel" };
+	int status = 0;
+	IntelHex hex[3];
+	FILE *file;
+	struct stat fileStatus;
+	double seconds;
+	int numberOfReaders = sizeof(readers) / sizeof(readers[0]);
+	int reader;
+	int i;
+
+	if(stat(filename, &fileStatus) != 0)
+	{
+		printf("cannot find \"%s\"\n\n", filename);
+		return -1;
+	}
+
+	printf("reading hex file, \"%s\", %lld bytes, %d times with each reader:\n", filename, (long long)fileStatus.st_size, iterations);
+
+	for(reader = 0; reader < numberOfReaders; reader++)
+		intelHex_initializeHexInfo(&hex[reader], 0);
+
+	for(reader = 0; reader < numberOfReaders && status == 0; reader++)
+	{
+		seconds = getSeconds();
+
+		for(i = 0; i < iterations && status == 0; i++)
+		{
+			intelHex_destroyHexInfo(&hex[reader]);
+
+			if((file = fopen(filename, "r")) == NULL)
+				status = -1;
+			else
+			{
+				status = readers[reader](file, &hex[reader], INTEL_HEX_IGNORE_UNKNOWN_RECORD);
+				fclose(file);
+			}
+		}
+
+		seconds = getSeconds() - seconds;
+
+		if(status == 0)
+			printf("  %s: %.3f ms per read, %.1f MB/s\n", readerNames[reader], seconds * 1000 / iterations, (fileStatus.st_size * (double)iterations) / (seconds * 1e6));
+		else
+			printf("  %s: FAILED\n", readerNames[reader]);
+	}
+
+	if(status == 0)
+	{
+		for(reader = 1; reader < numberOfReaders && isSameHexInfo(&hex[0], &hex[reader]); reader++);
+
+		status = (reader == numberOfReaders) ? 0 : -1;
+		printf("  results: %s\n", (status == 0) ? "identical" : "DIFFERENT");
+	}
+
+	printf("\n");
+
+	for(reader = 0; reader < numberOfReaders; reader++)
+		intelHex_destroyHexInfo(&hex[reader]);
+
+	return status;
+}
+
+static int printDigests(int inputFormat, const char *filename, uint32_t pageSize)
+{
+	IntelHexDigest *digests;
+	IntelHexDigest imageDigest;
+	uint32_t numberOfDigests;
+	IntelHex hex;
+	uint32_t i;
+
+	if(intelHex_convert(inputFormat, filename, NULL, 0, NULL, &hex, INTEL_HEX_IGNORE_UNKNOWN_RECORD) != 0)
+	{
+		printf("cannot read \"%s\"\n\n", filename);
+		return -1;
+	}
+
+	if(intelHex_getDigests(&hex, pageSize, &digests, &numberOfDigests, &imageDigest) != 0)
+	{
+		intelHex_destroyHexInfo(&hex);
+		return -1;
+	}
+
+	printf("digests of %s file, \"%s\", with %u-byte pages:\n", getFileFormatName(inputFormat), filename, pageSize);
+
+	for(i = 0; i < numberOfDigests; i++)
+		printf("  page %u: crc16 0x%.4x, hash 0x%.16llx\n", digests[i].page, digests[i].crc, (unsigned long long)digests[i].hash);
+
+	printf("  image: %u pages, crc16 0x%.4x, hash 0x%.16llx\n\n", imageDigest.page, imageDigest.crc, (unsigned long long)imageDigest.hash);
+
+	if(digests != NULL)
+		free(digests);
+
+	intelHex_destroyHexInfo(&hex);
+	return 0;
+}
+
+static int checkStreamedData(StreamConverter *converter, uint32_t baseAddress, uint64_t size)
+{
+	if(baseAddress < converter->nextAddress)
+	{
+		converter->isInOrder = 0;
+		return -1;
+	}
+
+	converter->nextAddress = baseAddress + size;
+	converter->lastAddress = baseAddress + size - 1;
+	converter->hasData = 1;
+
+	return 0;
+}
+
+static int flushStreamWindow(StreamConverter *converter)
+{
+	int status = 0;
+
+	if(converter->windowSize > 0)
+		status = writeDataToHexFile(&converter->writer, converter->windowAddress, converter->window, converter->windowSize);
+
+	converter->windowAddress += converter->windowSize;
+	converter->windowSize = 0;
+
+	return status;
+}
+
+static int startStreamedRegion(StreamConverter *converter, uint32_t baseAddress)
+{
+	long position;
+
+	converter->numberOfRegions++;
+	converter->windowAddress = baseAddress;
+
+	if(converter->writer.format == INTEL_HEX_FORMAT_HEX)
+		return 0;
+
+	if((position = ftell(converter->writer.file)) < 0)
+	{
+		ERROR("failed to get the position indicator of bin file\n");
+		return -1;
+	}
+
+	converter->chunkSizePosition = position + converter->writer.size + 4;
+	converter->chunkSize = 0;
+
+	if(writeValueToBinFile(&converter->writer, baseAddress) != 0 || writeValueToBinFile(&converter->writer, 0) != 0)
+	{
+		ERROR("failed to write data base address and size info to bin file\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int stopStreamedRegion(StreamConverter *converter)
+{
+	if(converter->writer.format == INTEL_HEX_FORMAT_HEX)
+		return flushStreamWindow(converter);
+
+	if(flushWriter(&converter->writer) != 0)
+		return -1;
+
+	if(fseek(converter->writer.file, converter->chunkSizePosition, SEEK_SET) != 0 || writeValueToBinFile(&converter->writer, (uint32_t)converter->chunkSize) != 0 ||
+			flushWriter(&converter->writer) != 0 || fseek(converter->writer.file, 0, SEEK_END) != 0)
+	{
+		ERROR("failed to write data size info to bin file\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int writeStreamedData(StreamConverter *converter, uint32_t baseAddress, const uint8_t *data, uint64_t size)
+{
+	uint32_t blockSize;
+	uint32_t length;
+
+	if(!converter->hasData || baseAddress != converter->nextAddress)
+	{
+		if(converter->hasData && stopStreamedRegion(converter) != 0)
+			return -1;
+
+		if(startStreamedRegion(converter, baseAddress) != 0)
+			return -1;
+	}
+
+	converter->nextAddress = baseAddress + size;
+	converter->hasData = 1;
+	converter->bytes += size;
+
+	if(converter->writer.format == INTEL_HEX_FORMAT_BIN)
+	{
+		converter->chunkSize += size;
+		return writeBytesToBinFile(&converter->writer, data, size);
+	}
+
+	while(size > 0)
+	{
+		blockSize = 0x10000 - (converter->windowAddress & converter->blockMask);
+
+		if((length = blockSize - converter->windowSize) > size)
+			length = size;
+
+		memcpy(&converter->window[converter->windowSize], data, length);
+		converter->windowSize += length;
+		data += length;
+		size -= length;
+
+		if(converter->windowSize == blockSize && flushStreamWindow(converter) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int checkStreamedHexData(void *context, uint32_t baseAddress, const uint8_t *data, uint32_t size)
+{
+	(void)data;
+
+	return checkStreamedData((StreamConverter *)context, baseAddress, size);
+}
 
-		if(readValueFromHexFile(file, 2, &byteCount) != 0)
-		{
-			ERROR("failed to read record byte count info from hex file\n");
-			return -1;
-		}
+static int writeStreamedHexData(void *context, uint32_t baseAddress, const uint8_t *data, uint32_t size)
+{
+	return writeStreamedData((StreamConverter *)context, baseAddress, data, size);
+}
 
-		if(readValueFromHexFile(file, 4, &offset) != 0)
-		{
-			ERROR("failed to read record address offset info from hex file\n");
-			return -1;
-		}
+static int streamBinFile(FILE *file, StreamConverter *converter, int isWriting)
+{
+	IntelHex *hex = &converter->hex;
+	struct stat fileStatus;
+	uint8_t *buffer = NULL;
+	uint64_t memorySize;
+	uint32_t baseAddress;
+	uint32_t size;
+	uint32_t length;
+	int status = -1;
 
-		if(readValueFromHexFile(file, 2, &recordType) != 0)
-		{
-			ERROR("failed to read record type info from hex file\n");
-			return -1;
-		}
+	/**
+	 * same checks and errors as readHexInfoFromBinFile(); memory chunks are
+	 * skipped over while checking and read a buffer at a time while writing
+	 */
 
-		checksum = byteCount + (offset & 0xff) + (offset >> 8) + recordType;
+	if(fstat(fileno(file), &fileStatus) != 0)
+	{
+		ERROR("failed to get the size of bin file\n");
+		return -1;
+	}
 
-		for(i = 0; (uint32_t)i < byteCount; i++)
-		{
-			if(readValueFromHexFile(file, 2, &value) != 0)
-			{
-				ERROR("failed to read record data byte from hex file\n");
-				return -1;
-			}
+	if(isWriting && (buffer = (uint8_t *)malloc(STREAM_BUFFER_SIZE)) == NULL)
+	{
+		ERROR("failed to allocate memory for bin file buffer\n");
+		return -1;
+	}
 
-			buffer[i] = (uint8_t)value;
-			checksum += value;
-		}
+	if(readValueFromBinFile(&hex->eip, file) != 0)
+		ERROR("failed to read EIP info from bin file\n");
+	else if(readValueFromBinFile(&hex->cs, file) != 0)
+		ERROR("failed to read CS info from bin file\n");
+	else if(readValueFromBinFile(&hex->ip, file) != 0)
+		ERROR("failed to read IP info from bin file\n");
+	else if(checkEip(hex->eip) == 0 && checkCsAndIp(hex->cs, hex->ip) == 0)
+		status = 0;
 
-		if(readValueFromHexFile(file, 2, &value) != 0)
+	while(status == 0 && fgetc(file) != EOF)
+	{
+		status = -1;
+
+		if(fseek(file, -1, SEEK_CUR) != 0)
 		{
-			ERROR("failed to read record checksum info from hex file\n");
-			return -1;
+			ERROR("failed to set the position indicator of bin file\n");
+			break;
 		}
 
-		if(((checksum + value) & 0xff) != 0)
+		if(readValueFromBinFile(&baseAddress, file) != 0)
 		{
-			ERROR("wrong record checksum\n");
-			return -1;
+			ERROR("failed to read data base address info from bin file\n");
+			break;
 		}
 
-		if(recordType == INTEL_HEX_RECORD_DATA)
+		if(readValueFromBinFile(&size, file) != 0)
 		{
-			data = buffer;
-
-			while(byteCount > 0)
-			{
-				if(isLinear)
-				{
-					address = (baseAddress + offset) & MAX_32BIT;
-					size = (uint64_t)(MAX_32BIT - address) + 1ULL;
-
-					if(size > byteCount)
-						size = byteCount;
-				}
-				else
-				{
-					offset &= 0xffff;
-					address = baseAddress + offset;
-					size = ((offset + byteCount) > 0x10000) ? (0x10000 - offset) : byteCount;
-				}
+			ERROR("failed to read data size info from bin file\n");
+			break;
+		}
 
-				if(intelHex_saveDataToHexInfo(hex, data, NULL, size, address) != 0)
-					return -1;
+		memorySize = (size == 0) ? 0x100000000ULL : (uint64_t)size;
 
-				data += size;
-				byteCount -= size;
-				offset += size;
-			}
-		}
-		else if(recordType == INTEL_HEX_RECORD_END_OF_FILE)
+		if(baseAddress > hex->endmostAddress || (memorySize - 1) > (hex->endmostAddress - baseAddress))
 		{
-			if(byteCount != 0 || offset != 0x0000)
-			{
-				ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
-				return -1;
-			}
+			ERROR("hex memory at 0x%.8x with %llu bytes exceeded the maximum address of 0x%.8x\n", baseAddress, (unsigned long long)memorySize, hex->endmostAddress);
+			break;
 		}
-		else if(recordType == INTEL_HEX_RECORD_EXTENDED_SEGMENT_ADDRESS)
-		{
-			if(byteCount != 2 || offset != 0x0000)
-			{
-				ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
-				return -1;
-			}
 
-			baseAddress = (buffer[0] << 8 | buffer[1]) << 4;
-			isLinear = 0;
-		}
-		else if(recordType == INTEL_HEX_RECORD_EXTENDED_LINEAR_ADDRESS)
+		if(!isWriting)
 		{
-			if(byteCount != 2 || offset != 0x0000)
-			{
-				ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
-				return -1;
-			}
+			if(checkStreamedData(converter, baseAddress, memorySize) != 0)
+				break;
 
-			baseAddress = (buffer[0] << 8 | buffer[1]) << 16;
-			isLinear = 1;
-		}
-		else if(recordType == INTEL_HEX_RECORD_START_LINEAR_ADDRESS)
-		{
-			if(byteCount != 4 || offset != 0x0000)
+			if(memorySize > (uint64_t)(fileStatus.st_size - ftell(file)))
 			{
-				ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
-				return -1;
+				ERROR("failed to read %llu bytes from input file\n", (unsigned long long)memorySize);
+				break;
 			}
 
-			if(IS_VALID_ADDRESS(hex->eip))
+			if(fseek(file, (long)memorySize, SEEK_CUR) != 0)
 			{
-				ERROR("duplicate record for start linear address (EIP)\n");
-				return -1;
+				ERROR("failed to set the position indicator of bin file\n");
+				break;
 			}
-
-			hex->eip = (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
 		}
-		else if(recordType == INTEL_HEX_RECORD_START_SEGMENT_ADDRESS)
+		else
 		{
-			if(byteCount != 4 || offset != 0x0000)
+			for(; memorySize > 0; memorySize -= length, baseAddress += length)
 			{
-				ERROR("wrong record info for type 0x%x: byteCount=%u addressOffset=0x%.4x\n", recordType, byteCount, offset);
-				return -1;
-			}
+				length = (memorySize > STREAM_BUFFER_SIZE) ? STREAM_BUFFER_SIZE : (uint32_t)memorySize;
 
-			if(IS_VALID_ADDRESS(hex->cs)) // and IP
-			{
-				ERROR("duplicate record for start segment address (CS and IP)\n");
-				return -1;
+				if(fread(buffer, 1, length, file) != length)
+				{
+					ERROR("failed to read %u bytes from input file\n", length);
+					break;
+				}
+
+				if(writeStreamedData(converter, baseAddress, buffer, length) != 0)
+					break;
 			}
 
-			hex->cs = (buffer[0] << 8) | buffer[1];
-			hex->ip = (buffer[2] << 8) | buffer[3];
-		}
-		else if((flags & INTEL_HEX_IGNORE_UNKNOWN_RECORD))
-			WARNING("unknown record of type 0x%x\n", recordType);
-		else
-		{
-			ERROR("unknown record of type 0x%x\n", recordType);
-			return -1;
+			if(memorySize > 0)
+				break;
 		}
 
-		notFirstRecord = 1;
+		status = 0;
 	}
 
-	return -1;
+	if(status == 0 && ferror(file))
+	{
+		ERROR("EOF not found in bin file\n");
+		status = -1;
+	}
+
+	if(buffer != NULL)
+		free(buffer);
+
+	return status;
 }
 
-/******************************************************************************
- * conversion
+/**
+ * convert a file without loading its data in memory
+ *
+ * the input file is read twice: first to check the data and find the
+ *   addressing, then to write the output file
+ *
+ * 0 if successful, 1 if data is out of order or either file is not a
+ *   regular file, so the file has to be converted in memory, -1 otherwise
  */
-
-int intelHex_convert(int inputFormat, const char *inputFilename, const IntelHex *inputHex, int outputFormat, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
+static int streamConversion(int inputFormat, const char *inputFilename, int outputFormat, const char *outputFilename, uint32_t flags, StreamConverter *converter)
 {
-	int status = -1;
+	struct stat fileStatus;
 	FILE *inputFile;
 	FILE *outputFile;
-	IntelHex hex;
+	uint32_t endAddress;
+	int status;
+
+	intelHex_initializeHexInfo(&converter->hex, flags);
+	converter->writer.buffer = NULL;
+	converter->window = NULL;
+	converter->windowSize = 0;
+	converter->nextAddress = 0;
+	converter->hasData = 0;
+	converter->isInOrder = 1;
+	converter->numberOfRegions = 0;
+	converter->bytes = 0;
 
-	if((inputFilename == NULL && inputHex == NULL) || (inputFilename != NULL && inputHex != NULL))
-	{
-		ERROR("at most one of inputFilename and inputHex must be specified\n");
-		return -1;
-	}
+	/**
+	 * note: sizes of memory chunks are written back into bin output file,
+	 *       so both files have to be seekable
+	 */
+	if(stat(inputFilename, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode))
+		return 1;
 
-	if(outputFilename == NULL && outputHex == NULL)
+	if(outputFormat == INTEL_HEX_FORMAT_BIN && stat(outputFilename, &fileStatus) == 0 && !S_ISREG(fileStatus.st_mode))
+		return 1;
+
+	if((inputFile = fopen(inputFilename, (inputFormat == INTEL_HEX_FORMAT_HEX) ? "r" : "rb")) == NULL)
 	{
-		ERROR("at least one of outputFilename and outputHex must be specified\n");
+		ERROR("failed to open \"%s\" file for reading\n", inputFilename);
 		return -1;
 	}
 
-	if(openFiles(&inputFile, inputFilename, (inputFormat == INTEL_HEX_FORMAT_HEX) ? "r" : "rb", &outputFile, outputFilename, (outputFormat == INTEL_HEX_FORMAT_HEX) ? "w" : "wb") != 0)
-		return -1;
-
-	if(outputHex == NULL)
-		outputHex = &hex;
-
-	if(inputFile == NULL)
-		status = copyHexInfo(inputHex, outputHex, flags);
+	if(inputFormat == INTEL_HEX_FORMAT_HEX)
+		status = readHexInfoFromMappedHexFile(inputFile, &converter->hex, flags, 1, checkStreamedHexData, converter);
 	else
-	{
-		if(inputFormat == INTEL_HEX_FORMAT_HEX)
-			status = readHexInfoFromHexFile(inputFile, outputHex, flags);
-		else
-			status = readHexInfoFromBinFile(inputFile, outputHex, flags);
+		status = streamBinFile(inputFile, converter, 0);
 
+	if(status != 0)
+	{
 		fclose(inputFile);
+		return converter->isInOrder ? -1 : 1;
 	}
 
-	if(outputFile != NULL)
-	{
-		if(status == 0)
-		{
-			if(outputFormat == INTEL_HEX_FORMAT_HEX)
-				status = writeHexInfoToHexFile(outputHex, outputFile, INTEL_HEX_FLAGS_RECORD_LENGTH(flags));
-			else
-				status = writeHexInfoToBinFile(outputHex, outputFile);
-		}
+	rewind(inputFile);
 
-		fclose(outputFile);
+	if((outputFile = fopen(outputFilename, (outputFormat == INTEL_HEX_FORMAT_HEX) ? "w" : "wb")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for writing\n", outputFilename);
+		fclose(inputFile);
+		return -1;
 	}
 
-	if(status != 0 || outputHex == &hex)
-		intelHex_destroyHexInfo(outputHex);
-
-	return status;
-}
-
-inline int intelHex_hexToBin(const char *inputFilename, const IntelHex *inputHex, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
-{
-	return intelHex_convert(INTEL_HEX_FORMAT_HEX, inputFilename, inputHex, INTEL_HEX_FORMAT_BIN, outputFilename, outputHex, flags);
-}
+	endAddress = converter->hasData ? getEndAddress(converter->hex.endAddress, converter->lastAddress) : converter->hex.endAddress;
 
-inline int intelHex_binToHex(const char *inputFilename, const IntelHex *inputHex, const char *outputFilename, IntelHex *outputHex, uint32_t flags)
-{
-	return intelHex_convert(INTEL_HEX_FORMAT_BIN, inputFilename, inputHex, INTEL_HEX_FORMAT_HEX, outputFilename, outputHex, flags);
-}
+	converter->blockMask = (endAddress == MAX_16BIT) ? 0xf : 0xffff;
+	converter->nextAddress = 0;
+	converter->hasData = 0;
 
-#ifdef INTELHEX_STANDALONE
+	if((converter->window = (uint8_t *)malloc(STREAM_BUFFER_SIZE)) == NULL)
+	{
+		ERROR("failed to allocate memory for data window\n");
+		status = -1;
+	}
+	else
+		status = startWriting(&converter->writer, outputFormat, outputFile, converter->hex.eip, converter->hex.cs, converter->hex.ip, endAddress, flags);
 
-static void usage(const char *name)
-{
-	ERROR("wrong parameter\n");
+	if(status == 0)
+	{
+		if(inputFormat == INTEL_HEX_FORMAT_HEX)
+			status = readHexInfoFromMappedHexFile(inputFile, &converter->hex, flags, 1, writeStreamedHexData, converter);
+		else
+			status = streamBinFile(inputFile, converter, 1);
+	}
 
-	printf(PREFIX "usage:\n"
-			"  \n"
-			"  %s <input file format: \"-hex\" or \"-bin\"> <input file> <output file format: \"-hex\" or \"-bin\"> <output file> [optional parameters]\n"
-			"  \n"
-			"  [optional parameters]\n"
-			"    -rl<[0 to 255]>, to specify the maximum data record length; 0 to 255 bytes\n"
-			"    -ur, to allow unknown record\n"
-			"    -ad<[8,16,32]>, to force the addressing\n"
-			"  \n",
-			name);
-}
+	if(status == 0 && converter->hasData)
+		status = stopStreamedRegion(converter);
 
-static int getDecimalValue(const char *data, int maxDigits)
-{
-	int value = 0;
-	int multiplier = 1;
-	int i = strlen(data);
+	if(converter->writer.buffer != NULL && stopWriting(&converter->writer) != 0)
+		status = -1;
 
-	if(i < 1 || i > maxDigits || (i > 1 && *data == '0'))
-		return -1;
+	if(fclose(outputFile) != 0)
+		status = -1;
 
-	while(i-- > 0)
-	{
-		if(!isdigit(data[i]))
-			return -1;
+	fclose(inputFile);
 
-		value += ((data[i] - '0') * multiplier);
-		multiplier *= 10;
-	}
+	if(converter->window != NULL)
+		free(converter->window);
 
-	return value;
+	return status;
 }
 
 int main(int argc, char **argv)
@@ -1233,22 +3185,46 @@ int main(int argc, char **argv)
 	int outputFormat;
 	IntelHex hex;
 	IntelHexMemory *memory;
+	StreamConverter converter;
+	struct stat fileStatus;
+	double seconds;
+	int isStreaming = 0;
+	int isStreamed = 0;
+	int pageShift;
+	int status = 1;
 	int value;
 	int i;
 
-	if(argc < 5)
+	if(argc > 2 && strcmp(argv[1], "-bench") == 0)
 	{
-		usage(argv[0]);
-		return -1;
+		if(argc > 4 || (value = (argc == 4) ? getDecimalValue(argv[3], 6) : 10) < 1)
+		{
+			usage(argv[0]);
+			return -1;
+		}
+
+		return benchmark(argv[2], value);
+	}
+
+	if(argc > 2 && strcmp(argv[1], "-digest") == 0)
+	{
+		if(argc < 4 || argc > 5 || (value = (argc == 5) ? getDecimalValue(argv[4], 7) : DIGEST_PAGE_SIZE) < 1 ||
+				(inputFormat = getFileFormat(argv[2])) < 0)
+		{
+			usage(argv[0]);
+			return -1;
+		}
+
+		return printDigests(inputFormat, argv[3], value);
 	}
 
-	if((inputFormat = (strcmp(argv[1], "-hex") == 0) ? INTEL_HEX_FORMAT_HEX : INTEL_HEX_FORMAT_BIN) != INTEL_HEX_FORMAT_HEX && strcmp(argv[1], "-bin") != 0)
+	if(argc < 5)
 	{
 		usage(argv[0]);
 		return -1;
 	}
 
-	if((outputFormat = (strcmp(argv[3], "-hex") == 0) ? INTEL_HEX_FORMAT_HEX : INTEL_HEX_FORMAT_BIN) != INTEL_HEX_FORMAT_HEX && strcmp(argv[3], "-bin") != 0)
+	if((inputFormat = getFileFormat(argv[1])) < 0 || (outputFormat = getFileFormat(argv[3])) < 0)
 	{
 		usage(argv[0]);
 		return -1;
@@ -1260,6 +3236,8 @@ int main(int argc, char **argv)
 		{
 			if(strcmp(argv[i], "-ur") == 0)
 				flags |= INTEL_HEX_IGNORE_UNKNOWN_RECORD;
+			else if(strcmp(argv[i], "-st") == 0)
+				isStreaming = 1;
 			else
 			{
 				usage(argv[0]);
@@ -1303,6 +3281,30 @@ int main(int argc, char **argv)
 					return -1;
 				}
 			}
+			else if(strncmp(argv[i], "-id", 3) == 0)
+			{
+				if((value = getDecimalValue(&argv[i][3], 3)) < 0 || value > 255)
+				{
+					usage(argv[0]);
+					return -1;
+				}
+
+				INTEL_HEX_FLAGS_SET_CHIP_ID(flags, value);
+			}
+			else if(strncmp(argv[i], "-ps", 3) == 0)
+			{
+				value = getDecimalValue(&argv[i][3], 5);
+
+				for(pageShift = 1; pageShift <= 15 && (1 << pageShift) != value; pageShift++);
+
+				if(pageShift > 15)
+				{
+					usage(argv[0]);
+					return -1;
+				}
+
+				INTEL_HEX_FLAGS_SET_PAGE_SHIFT(flags, pageShift);
+			}
 			else
 			{
 				usage(argv[0]);
@@ -1311,23 +3313,51 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if(inputFormat == INTEL_HEX_FORMAT_IMAGE || outputFormat == INTEL_HEX_FORMAT_IMAGE)
+		isStreaming = 0;
+
 	printf("converting %s file, \"%s\", to %s file, \"%s\", with parameters:\n"
 			"  ignore unknown records: %s\n"
 			"  addressing: %s\n"
 			"  data record length: %d bytes %s\n"
-			"  \n",
-				(inputFormat == INTEL_HEX_FORMAT_HEX) ? "hex" : "bin",
+			"  streaming: %s\n",
+				getFileFormatName(inputFormat),
 				argv[2],
-				(outputFormat == INTEL_HEX_FORMAT_HEX) ? "hex" : "bin",
+				getFileFormatName(outputFormat),
 				argv[4],
 				((flags & INTEL_HEX_IGNORE_UNKNOWN_RECORD)) ? "YES" : "NO",
 				(INTEL_HEX_FLAGS_ADDRESSING(flags) == INTEL_HEX_8BIT_ADDRESSING) ? "8-bit" :
 						((INTEL_HEX_FLAGS_ADDRESSING(flags) == INTEL_HEX_16BIT_ADDRESSING) ? "16-bit" :
 								((INTEL_HEX_FLAGS_ADDRESSING(flags) == INTEL_HEX_32BIT_ADDRESSING) ? "32-bit" : "auto")),
 				(INTEL_HEX_FLAGS_RECORD_LENGTH(flags) == 0) ? DEFAULT_RECORD_LENGTH : INTEL_HEX_FLAGS_RECORD_LENGTH(flags),
-						(INTEL_HEX_FLAGS_RECORD_LENGTH(flags) == 0) ? "(default)" : "");
+						(INTEL_HEX_FLAGS_RECORD_LENGTH(flags) == 0) ? "(default)" : "",
+				isStreaming ? "YES" : "NO");
+
+	if(outputFormat == INTEL_HEX_FORMAT_IMAGE)
+		printf("  chip ID: 0x%.2x %s\n"
+				"  page size: %u bytes %s\n",
+				INTEL_HEX_FLAGS_CHIP_ID(flags), (INTEL_HEX_FLAGS_CHIP_ID(flags) == 0) ? "(any chip)" : "",
+				(INTEL_HEX_FLAGS_PAGE_SHIFT(flags) == 0) ? INTEL_HEX_DEFAULT_PAGE_SIZE : (1 << INTEL_HEX_FLAGS_PAGE_SHIFT(flags)),
+						(INTEL_HEX_FLAGS_PAGE_SHIFT(flags) == 0) ? "(default)" : "");
+
+	printf("  \n");
+
+	seconds = getSeconds();
 
-	if(intelHex_convert(inputFormat, argv[2], NULL, outputFormat, argv[4], &hex, flags) != 0)
+	if(isStreaming && (status = streamConversion(inputFormat, argv[2], outputFormat, argv[4], flags, &converter)) > 0)
+		printf("data is out of order, or not in a regular file; converting in memory\n\n");
+
+	if(status > 0)
+		status = intelHex_convert(inputFormat, argv[2], NULL, outputFormat, argv[4], &hex, flags);
+	else
+	{
+		hex = converter.hex;
+		isStreamed = 1;
+	}
+
+	seconds = getSeconds() - seconds;
+
+	if(status != 0)
 	{
 		printf("conversion failed!\n\n");
 		return -1;
@@ -1343,6 +3373,12 @@ int main(int argc, char **argv)
 	for(i = 0, memory = hex.memory; memory != NULL; i++, memory = memory->next)
 		printf("  mem%d: 0x%.8x ~ 0x%.8x, %u bytes\n", i, memory->baseAddress, memory->baseAddress + memory->size - 1, memory->size);
 
+	if(isStreamed)
+		printf("  memory: %u regions, %llu bytes, streamed\n", converter.numberOfRegions, (unsigned long long)converter.bytes);
+
+	if(isStreaming && stat(argv[2], &fileStatus) == 0)
+		printf("  throughput: %.1f MB/s, %lld bytes in %.3f s\n", fileStatus.st_size / (seconds * 1e6), (long long)fileStatus.st_size, seconds);
+
 	printf("\n");
 
 	intelHex_destroyHexInfo(&hex);
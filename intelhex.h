@@ -50,6 +50,51 @@
  *       with the latter represented as "0" due to overflow
  */
 
+/**
+ * image file format (little-endian)
+ *
+ * offset         size (bytes)    description
+ * --------------------------------------------------------------------
+ * 0              4               "IHXI"
+ * 4              4               version, 1
+ * 8              4               header size, 64
+ * 12             4               EIP address
+ * 16             4               CS address
+ * 20             4               IP address
+ * 24             4               chip ID, 0 for any chip
+ * 28             4               page size
+ * 32             4               first page
+ * 36             4               number of pages, N, from first page on
+ * 40             4               number of payloads, P
+ * 44             4               offset of payloads
+ * 48             4               number of pages with data
+ * 52             4               CRC16 of the pages with data
+ * 56             8               hash of the pages with data
+ * 64             (N + 7) / 8     page map; bit (i % 8) of byte (i / 8) is
+ *                                set if page (first page + i) has data
+ * 64 + map       8 * N           page entries, one per page from first page on
+ * o              P * page size   payloads, one per page with data that is not
+ *                                blank
+ * o + payloads   0               EOF
+ * --------------------------------------------------------------------
+ *
+ * page entry:
+ *
+ * offset         size (bytes)    description
+ * --------------------------------------------------------------------
+ * 0              2               CRC16 of the page
+ * 2              2               page flags, INTEL_HEX_PAGE_BLANK and
+ *                                INTEL_HEX_PAGE_PARTIAL
+ * 4              4               payload index, 0xffffffff if none
+ * --------------------------------------------------------------------
+ *
+ * note: pages are whole, with 0xff for bytes without data as in erased
+ *       flash; a page is blank if all of its bytes are 0xff
+ * note: offset of payloads is a multiple of 4096 and of page size, so
+ *       payloads can be mapped a page at a time
+ * note: CRC16 and hash of the pages are those of intelHex_getDigests()
+ */
+
 #ifndef INTELHEX_H_
 #define INTELHEX_H_
 
@@ -66,49 +111,112 @@
 #define INTEL_HEX_INVALID_ADDRESS		((uint32_t)-1)
 
 /**
- * hex data
- */
-typedef struct IntelHexData {
-	struct IntelHexData *next;
-	uint32_t size;
-	uint8_t *data;
-} IntelHexData;
-
-/**
- * hex memory
+ * hex memory; a contiguous region whose data is kept in a single extent,
+ *   so the byte at address is data[address - baseAddress]
  */
 typedef struct IntelHexMemory {
 	struct IntelHexMemory *next;
 	uint32_t baseAddress;
 	uint32_t size;
-	IntelHexData *head;
-	IntelHexData *tail;
+	uint64_t capacity;		/* allocated size of data; grows geometrically, 0 if
+							   data points into the mapping of the input file */
+	uint8_t *data;
 } IntelHexMemory;
 
 /**
  * hex info
+ *
+ * note: memory is a list sorted by base address; regions indexes the same
+ *       list for binary search, and lastRegion is the position in regions of
+ *       the memory that data was last saved to, which is where sequential
+ *       records go next; mapping is the input file when its data is used
+ *       in place, which lasts until hex info structure is destroyed
  */
 typedef struct {
 	uint32_t eip;
 	uint32_t cs;
 	uint32_t ip;
 	IntelHexMemory *memory;
+	IntelHexMemory **regions;
+	uint32_t numberOfRegions;
+	uint32_t regionsCapacity;
+	uint32_t lastRegion;
 	uint32_t endAddress;
 	uint32_t endmostAddress;
+	void *mapping;
+	uint64_t mappingSize;
 } IntelHex;
 
+/**
+ * streaming writer
+ */
+typedef struct {
+	FILE *file;
+	int format;
+	uint32_t endAddress;		/* decides the addressing, as in IntelHex */
+	uint32_t recordLength;
+	uint32_t extendedAddress;	/* of the last extended address record written */
+	uint8_t *buffer;			/* output waiting to be written to file */
+	uint32_t size;
+} IntelHexWriter;
+
+/**
+ * digest of a page, or of a whole image
+ */
+typedef struct {
+	uint32_t page;		/* page number, or number of pages of an image */
+	uint16_t crc;
+	uint64_t hash;
+} IntelHexDigest;
+
+/**
+ * page of an image file
+ */
+typedef struct {
+	uint32_t page;
+	uint16_t crc;
+	uint16_t flags;
+	const uint8_t *data;	/* in the mapping of the file; NULL if blank */
+} IntelHexPage;
+
+/**
+ * image file, mapped for reading
+ *
+ * note: see the image file format above; digest holds the number of
+ *       pages with data, and their CRC16 and hash
+ */
+typedef struct {
+	uint32_t eip;
+	uint32_t cs;
+	uint32_t ip;
+	uint32_t chipId;
+	uint32_t pageSize;
+	uint32_t firstPage;
+	uint32_t numberOfPages;
+	uint32_t numberOfPayloads;
+	IntelHexDigest digest;
+	const uint8_t *pageMap;
+	const uint8_t *pageEntries;
+	const uint8_t *payloads;
+	void *mapping;
+	uint64_t mappingSize;
+} IntelHexImage;
+
 /**
  * format
  */
 enum {
 	INTEL_HEX_FORMAT_HEX,
-	INTEL_HEX_FORMAT_BIN
+	INTEL_HEX_FORMAT_BIN,
+	INTEL_HEX_FORMAT_IMAGE
 };
 
 /**
  * flags
  *
- * note: lower byte of flags is the record length
+ * note: lower byte of flags is the record length; for image files, the
+ *       second byte is the chip ID and bits 24 ~ 27 are log2 of the page
+ *       size, 0 for INTEL_HEX_DEFAULT_PAGE_SIZE
  */
 enum {
 	INTEL_HEX_IGNORE_UNKNOWN_RECORD		= 0x80000000,
@@ -117,10 +225,32 @@ enum {
 	INTEL_HEX_8BIT_ADDRESSING			= 0x00200000
 };
 
+/**
+ * seed of CRC16, as written twice to RNDL of CC253x
+ */
+#define INTEL_HEX_CRC16_SEED		0xffff
+
+/**
+ * page flags of image files
+ */
+enum {
+	INTEL_HEX_PAGE_BLANK		= 0x0001,
+	INTEL_HEX_PAGE_PARTIAL		= 0x0002
+};
+
+/**
+ * page size of image files unless set in flags
+ */
+#define INTEL_HEX_DEFAULT_PAGE_SIZE		2048
+
 #define INTEL_HEX_FLAGS_RECORD_LENGTH(flags)				((uint32_t)flags & 0x000000ff)
 #define INTEL_HEX_FLAGS_SET_RECORD_LENGTH(flags, length)	flags = (((uint32_t)flags & ~0x000000ff) | ((uint32_t)length & 0x000000ff))
 #define INTEL_HEX_FLAGS_ADDRESSING(flags)					((uint32_t)flags & 0x00ff0000)
 #define INTEL_HEX_FLAGS_SET_ADDRESSING(flags, addressing)	flags = (((uint32_t)flags & ~0x00ff0000) | ((uint32_t)addressing & 0x00ff0000))
+#define INTEL_HEX_FLAGS_CHIP_ID(flags)						(((uint32_t)flags & 0x0000ff00) >> 8)
+#define INTEL_HEX_FLAGS_SET_CHIP_ID(flags, id)				flags = (((uint32_t)flags & ~0x0000ff00) | (((uint32_t)id << 8) & 0x0000ff00))
+#define INTEL_HEX_FLAGS_PAGE_SHIFT(flags)					(((uint32_t)flags & 0x0f000000) >> 24)
+#define INTEL_HEX_FLAGS_SET_PAGE_SHIFT(flags, shift)		flags = (((uint32_t)flags & ~0x0f000000) | (((uint32_t)shift << 24) & 0x0f000000))
 
 /**
  * convert intel hexadecimal object file or binary file to intel hexadecimal object file or binary file
@@ -135,6 +265,10 @@ enum {
  *
  * 0 if successful, non-zero otherwise
  *
+ * note: bin and image input files are mapped, and outputHex uses the data
+ *       of their memory chunks and payloads in place where possible
+ * note: image files keep whole pages, so converting to one fills the gaps
+ *       of pages with data with 0xff
  * note: don't forget to destroy outputHex
  */
 int intelHex_convert(int inputFormat, const char *inputFilename, const IntelHex *inputHex, int outputFormat, const char *outputFilename, IntelHex *outputHex, uint32_t flags);
@@ -205,6 +339,180 @@ int intelHex_saveDataToHexInfo(IntelHex *hex, const uint8_t *data, FILE *file, u
  */
 int intelHex_copyDataFromHexInfo(IntelHex *hex, uint32_t baseAddress, uint8_t *data, FILE *file, uint64_t size);
 
+/**
+ * get a pointer to data in hex info structure, without copying it
+ *
+ * hex - IntelHex to get data from
+ * baseAddress - memory base address of data
+ * size - size of data
+ *
+ * pointer to the data, NULL if the data is not within a single memory
+ *   region
+ *
+ * note: the pointer is valid until hex info structure is changed or destroyed
+ */
+const uint8_t * intelHex_getData(const IntelHex *hex, uint32_t baseAddress, uint64_t size);
+
+/**
+ * read a raw binary file, i.e. data only, into hex info structure
+ *
+ * filename - name of raw input file
+ * offset - file offset of data
+ * size - size of data; 0 for the rest of the file
+ * baseAddress - memory base address of data
+ * hex - IntelHex to initialize and read into
+ * flags - conversion parameters
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: the file is mapped and its data used in place where possible
+ * note: don't forget to destroy hex
+ */
+int intelHex_readRawFile(const char *filename, uint64_t offset, uint64_t size, uint32_t baseAddress, IntelHex *hex, uint32_t flags);
+
+/**
+ * open a file for writing data straight to it, without keeping the data in
+ *   a hex info structure
+ *
+ * writer - IntelHexWriter to initialize
+ * format - file format of output file; hex or bin
+ * filename - name of output file
+ * lastAddress - highest address of the data to be written; along with flags,
+ *   decides the addressing of hex files
+ * flags - conversion parameters; record length and addressing
+ *
+ * 0 if successful, non-zero otherwise
+ */
+int intelHex_openWriter(IntelHexWriter *writer, int format, const char *filename, uint32_t lastAddress, uint32_t flags);
+
+/**
+ * write data to the file of a writer
+ *
+ * writer - IntelHexWriter to write with
+ * baseAddress - memory base address of data
+ * data - data to write
+ * size - size of data
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: data is encoded as it is written, so it can come in pieces, e.g.
+ *       as it is read from the chip; bin files get a memory chunk per call
+ */
+int intelHex_writeData(IntelHexWriter *writer, uint32_t baseAddress, const uint8_t *data, uint64_t size);
+
+/**
+ * finish the file of a writer and close it
+ *
+ * writer - IntelHexWriter to close
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: must be called even if writing failed
+ */
+int intelHex_closeWriter(IntelHexWriter *writer);
+
+/**
+ * compute CRC16 of data the way the CRC16 hardware of CC253x does when
+ *   data is written to RNDH: polynomial 0x8005 (x^16 + x^15 + x^2 + 1),
+ *   most significant bit first
+ *
+ * crc - seed, INTEL_HEX_CRC16_SEED, or CRC of the data before
+ * data - data
+ * size - size of data
+ *
+ * CRC16 of data
+ */
+uint16_t intelHex_crc16(uint16_t crc, const uint8_t *data, uint64_t size);
+
+/**
+ * compute 64-bit hash of data; XXH64, not cryptographic
+ *
+ * seed - seed
+ * data - data
+ * size - size of data
+ *
+ * hash of data
+ */
+uint64_t intelHex_hash64(uint64_t seed, const uint8_t *data, uint64_t size);
+
+/**
+ * compute digests of the pages with data in hex info structure, and of the
+ *   whole image
+ *
+ * hex - IntelHex to compute digests of
+ * pageSize - page size, e.g. flash page size of the chip
+ * digests - receives the digests of the pages, in address order
+ * numberOfDigests - receives the number of digests
+ * imageDigest - receives the number of pages, CRC16 of the pages one after
+ *   another, and hash of the hashes of the pages one after another
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: CRC16 starts from INTEL_HEX_CRC16_SEED and hash from 0; bytes of a
+ *       page without data are 0xff, as in erased flash
+ * note: don't forget to free digests
+ */
+int intelHex_getDigests(const IntelHex *hex, uint32_t pageSize, IntelHexDigest **digests, uint32_t *numberOfDigests, IntelHexDigest *imageDigest);
+
+/**
+ * open an image file for reading its pages in place
+ *
+ * filename - name of image file
+ * image - IntelHexImage to open
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: the file is mapped, so it must be a regular file
+ * note: don't forget to close image
+ */
+int intelHex_openImage(const char *filename, IntelHexImage *image);
+
+/**
+ * get a page of an image file
+ *
+ * image - IntelHexImage to get the page from
+ * page - page number
+ * imagePage - receives the page
+ *
+ * 0 if the page has data, non-zero otherwise
+ */
+int intelHex_getImagePage(const IntelHexImage *image, uint32_t page, IntelHexPage *imagePage);
+
+/**
+ * close an image file
+ *
+ * image - IntelHexImage to close
+ */
+void intelHex_closeImage(IntelHexImage *image);
+
+/**
+ * handler of data read from a file
+ *
+ * context - handler's own data
+ * baseAddress - memory base address of data
+ * data - data of one record, or part of it
+ * size - size of data
+ *
+ * 0 to carry on, non-zero to stop reading
+ */
+typedef int (* IntelHexDataHandler)(void *context, uint32_t baseAddress, const uint8_t *data, uint32_t size);
+
+/**
+ * read an intel hexadecimal object file record by record, handing its data
+ *   over as it is read instead of keeping it in a hex info structure
+ *
+ * filename - name of hex input file
+ * flags - conversion parameters
+ * handler - receives data, in file order
+ * context - passed on to handler
+ *
+ * 0 if successful, non-zero otherwise, or if handler stopped reading
+ *
+ * note: records are checked as they are read, so handler may have received
+ *       data before a bad record is found
+ */
+int intelHex_streamHexFile(const char *filename, uint32_t flags, IntelHexDataHandler handler, void *context);
+
 /**
  * destroy the contents of hex info structure
  *
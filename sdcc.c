@@ -0,0 +1,456 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Billy Millare
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * 18oct2026
+ */
+
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdcc.h"
+
+#define PREFIX			"sdcc: "
+
+#ifdef SDCC_VERBOSE
+#define ERROR(...)		fprintf(stderr, PREFIX "error: " __VA_ARGS__)
+#define WARNING(...)	fprintf(stderr, PREFIX "warning: " __VA_ARGS__)
+#else
+#define ERROR(...)
+#define WARNING(...)
+#endif
+
+#define LINE_SIZE			1024
+#define INITIAL_CAPACITY	256
+
+/******************************************************************************
+ * other helpers
+ */
+
+static int addSymbol(SdccSymbols *symbols, unsigned int address, unsigned int endAddress, const char *name, size_t nameLength)
+{
+	SdccSymbol *symbol;
+	unsigned int capacity;
+
+	if(symbols->numberOfSymbols == symbols->capacity)
+	{
+		capacity = (symbols->capacity == 0) ? INITIAL_CAPACITY : (symbols->capacity * 2);
+
+		if((symbol = (SdccSymbol *)realloc(symbols->symbols, capacity * sizeof(SdccSymbol))) == NULL)
+		{
+			ERROR("failed to allocate memory for symbols\n");
+			return -1;
+		}
+
+		symbols->symbols = symbol;
+		symbols->capacity = capacity;
+	}
+
+	symbol = &symbols->symbols[symbols->numberOfSymbols];
+
+	if((symbol->name = (char *)malloc(nameLength + 1)) == NULL)
+	{
+		ERROR("failed to allocate memory for symbol name\n");
+		return -1;
+	}
+
+	memcpy(symbol->name, name, nameLength);
+	symbol->name[nameLength] = '\0';
+	symbol->address = address;
+	symbol->endAddress = endAddress;
+	++symbols->numberOfSymbols;
+
+	return 0;
+}
+
+static int isIdentifier(const char *string, size_t length)
+{
+	size_t i;
+
+	if(length == 0 || !(isalpha((unsigned char)string[0]) || string[0] == '_'))
+		return 0;
+
+	for(i = 1; i < length; i++)
+	{
+		if(!(isalnum((unsigned char)string[i]) || string[i] == '_'))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int compareSymbolAddresses(const void *a, const void *b)
+{
+	const SdccSymbol *symbolA = (const SdccSymbol *)a;
+	const SdccSymbol *symbolB = (const SdccSymbol *)b;
+
+	if(symbolA->address != symbolB->address)
+		return (symbolA->address < symbolB->address) ? -1 : 1;
+
+	/**
+	 * symbols with known extents go first and survive deduplication
+	 */
+	return (symbolB->endAddress != 0) - (symbolA->endAddress != 0);
+}
+
+static int compareSymbolNames(const void *a, const void *b)
+{
+	return strcmp(((const SdccSymbol *)a)->name, ((const SdccSymbol *)b)->name);
+}
+
+static void sortSymbols(SdccSymbols *symbols)
+{
+	unsigned int i, j;
+
+	if(symbols->numberOfSymbols == 0)
+		return;
+
+	qsort(symbols->symbols, symbols->numberOfSymbols, sizeof(SdccSymbol), compareSymbolAddresses);
+
+	/**
+	 * the same code address usually turns up in more than one file
+	 */
+	for(i = 0, j = 1; j < symbols->numberOfSymbols; j++)
+	{
+		if(symbols->symbols[j].address == symbols->symbols[i].address)
+			free(symbols->symbols[j].name);
+		else
+			symbols->symbols[++i] = symbols->symbols[j];
+	}
+
+	symbols->numberOfSymbols = i + 1;
+}
+
+/******************************************************************************
+ * file readers
+ */
+
+static int readMapFile(FILE *file, SdccSymbols *symbols)
+{
+	char line[LINE_SIZE];
+	char name[LINE_SIZE];
+	unsigned int address;
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		/**
+		 * "     C:  0000009F  _main                              main"
+		 */
+		if(sscanf(line, " C: %x %s", &address, name) != 2 || !isIdentifier(name, strlen(name)))
+			continue;
+
+		if(addSymbol(symbols, address, 0, name, strlen(name)) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int readRstFile(FILE *file, SdccSymbols *symbols)
+{
+	char line[LINE_SIZE];
+	char name[LINE_SIZE];
+	const char *area;
+	unsigned int address;
+	unsigned int lineNumber;
+	size_t length;
+	int isCode = 0;
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		/**
+		 * "                                     12 	.area CSEG    (CODE)"
+		 */
+		if((area = strstr(line, ".area")) != NULL)
+		{
+			isCode = (strstr(area, "CODE") != NULL);
+			continue;
+		}
+
+		if(!isCode)
+			continue;
+
+		/**
+		 * "      00009F                        110 _main:"
+		 */
+		if(sscanf(line, "%x %u %s", &address, &lineNumber, name) != 3)
+			continue;
+
+		for(length = strlen(name); length > 0 && name[length - 1] == ':'; length--);
+
+		if(length == strlen(name) || !isIdentifier(name, length))
+			continue;
+
+		if(addSymbol(symbols, address, 0, name, length) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int readCdbFile(FILE *file, SdccSymbols *symbols)
+{
+	char line[LINE_SIZE];
+	SdccSymbols starts;
+	SdccSymbols ends;
+	const SdccSymbol *end;
+	const char *name;
+	const char *nameEnd;
+	char *record;
+	char *colon;
+	unsigned int address;
+	unsigned int i;
+	int result = 0;
+
+	sdcc_initializeSymbols(&starts);
+	sdcc_initializeSymbols(&ends);
+
+	/**
+	 * "L:G$main$0$0:9F" starts and "L:XG$main$0$0:C2" ends a global function;
+	 *   "L:Fmodule$name$0$0:..." and "L:XFmodule$name$0$0:..." a static one;
+	 *   variables have no end records and are left out
+	 */
+	while(result == 0 && fgets(line, sizeof(line), file) != NULL)
+	{
+		if(strncmp(line, "L:", 2) != 0)
+			continue;
+
+		record = &line[2];
+
+		if((colon = strrchr(record, ':')) == NULL || sscanf(colon + 1, "%x", &address) != 1)
+			continue;
+
+		*colon = '\0';
+
+		if(record[0] == 'X' && (record[1] == 'G' || record[1] == 'F'))
+			result = addSymbol(&ends, address, 0, &record[1], strlen(&record[1]));
+		else if(record[0] == 'G' || record[0] == 'F')
+			result = addSymbol(&starts, address, 0, record, strlen(record));
+	}
+
+	if(result == 0 && ends.numberOfSymbols > 0)
+	{
+		qsort(ends.symbols, ends.numberOfSymbols, sizeof(SdccSymbol), compareSymbolNames);
+
+		for(i = 0; i < starts.numberOfSymbols && result == 0; i++)
+		{
+			end = (const SdccSymbol *)bsearch(&starts.symbols[i], ends.symbols, ends.numberOfSymbols, sizeof(SdccSymbol), compareSymbolNames);
+
+			if(end == NULL || (name = strchr(starts.symbols[i].name, '$')) == NULL)
+				continue;
+
+			if((nameEnd = strchr(++name, '$')) == NULL)
+				nameEnd = name + strlen(name);
+
+			/**
+			 * the end record holds the address of the function's last byte
+			 */
+			result = addSymbol(symbols, starts.symbols[i].address, end->address + 1, name, nameEnd - name);
+		}
+	}
+
+	sdcc_destroySymbols(&starts);
+	sdcc_destroySymbols(&ends);
+
+	return result;
+}
+
+/**
+ * "G$name$0$0" or "Fmodule$name$0$0"
+ */
+static int isRecordOf(const char *record, const char *name)
+{
+	size_t length = strlen(name);
+
+	if(record[0] != 'G' && record[0] != 'F')
+		return 0;
+
+	if((record = strchr(record, '$')) == NULL)
+		return 0;
+
+	return (strncmp(++record, name, length) == 0 && record[length] == '$');
+}
+
+static int parseVariableType(const char *typeChain, SdccVariable *variable)
+{
+	const char *type;
+	int isSigned;
+
+	/**
+	 * "({2}SI:S),F,0,0" is a signed int in XDATA (address space F)
+	 */
+	if(sscanf(typeChain, "({%u}", &variable->size) != 1 || (type = strchr(typeChain, '}')) == NULL)
+		return -1;
+
+	if(strstr(type, "),F,") == NULL)
+		return -1;
+
+	isSigned = (strstr(type, ":S)") != NULL);
+	++type;
+
+	if(strncmp(type, "SC", 2) == 0 && variable->size == 1)
+		variable->type = isSigned ? SDCC_TYPE_S8 : SDCC_TYPE_U8;
+	else if(strncmp(type, "SI", 2) == 0 && variable->size == 2)
+		variable->type = isSigned ? SDCC_TYPE_S16 : SDCC_TYPE_U16;
+	else if(strncmp(type, "SL", 2) == 0 && variable->size == 4)
+		variable->type = isSigned ? SDCC_TYPE_S32 : SDCC_TYPE_U32;
+	else if(strncmp(type, "SF", 2) == 0 && variable->size == 4)
+		variable->type = SDCC_TYPE_F32;
+	else
+		variable->type = SDCC_TYPE_UNKNOWN;
+
+	return 0;
+}
+
+/******************************************************************************
+ * symbols
+ */
+
+void sdcc_initializeSymbols(SdccSymbols *symbols)
+{
+	symbols->numberOfSymbols = 0;
+	symbols->capacity = 0;
+	symbols->symbols = NULL;
+}
+
+void sdcc_destroySymbols(SdccSymbols *symbols)
+{
+	unsigned int i;
+
+	for(i = 0; i < symbols->numberOfSymbols; i++)
+		free(symbols->symbols[i].name);
+
+	free(symbols->symbols);
+	sdcc_initializeSymbols(symbols);
+}
+
+int sdcc_loadSymbols(SdccSymbols *symbols, const char *filename)
+{
+	const char *extension = strrchr(filename, '.');
+	FILE *file;
+	int result;
+
+	if(extension == NULL || (strcmp(extension, ".map") != 0 && strcmp(extension, ".rst") != 0 && strcmp(extension, ".cdb") != 0))
+	{
+		ERROR("\"%s\" is not a .map, .rst, or .cdb file\n", filename);
+		return -1;
+	}
+
+	if((file = fopen(filename, "r")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for reading\n", filename);
+		return -1;
+	}
+
+	if(strcmp(extension, ".map") == 0)
+		result = readMapFile(file, symbols);
+	else if(strcmp(extension, ".rst") == 0)
+		result = readRstFile(file, symbols);
+	else
+		result = readCdbFile(file, symbols);
+
+	fclose(file);
+	sortSymbols(symbols);
+
+	return result;
+}
+
+const SdccSymbol * sdcc_findSymbol(const SdccSymbols *symbols, unsigned int address)
+{
+	const SdccSymbol *symbol;
+	unsigned int low = 0;
+	unsigned int high = symbols->numberOfSymbols;
+	unsigned int middle;
+
+	while(low < high)
+	{
+		middle = (low + high) / 2;
+
+		if(symbols->symbols[middle].address <= address)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if(low == 0)
+		return NULL;
+
+	symbol = &symbols->symbols[low - 1];
+
+	if(symbol->endAddress != 0 && address >= symbol->endAddress)
+		return NULL;
+
+	return symbol;
+}
+
+const SdccSymbol * sdcc_findSymbolByName(const SdccSymbols *symbols, const char *name)
+{
+	unsigned int i;
+
+	for(i = 0; i < symbols->numberOfSymbols; i++)
+	{
+		if(strcmp(symbols->symbols[i].name, name) == 0)
+			return &symbols->symbols[i];
+	}
+
+	return NULL;
+}
+
+int sdcc_findVariable(const char *filename, const char *name, SdccVariable *variable)
+{
+	char line[LINE_SIZE];
+	FILE *file;
+	char *colon;
+	int hasType = 0;
+	int hasAddress = 0;
+
+	if((file = fopen(filename, "r")) == NULL)
+	{
+		ERROR("failed to open \"%s\" file for reading\n", filename);
+		return -1;
+	}
+
+	/**
+	 * "S:G$speed$0$0({2}SI:S),F,0,0" gives the type and
+	 *   "L:G$speed$0$0:F012" the address
+	 */
+	while(!(hasType && hasAddress) && fgets(line, sizeof(line), file) != NULL)
+	{
+		if(line[1] != ':' || !isRecordOf(&line[2], name))
+			continue;
+
+		if(line[0] == 'S' && !hasType)
+			hasType = ((colon = strchr(&line[2], '(')) != NULL && parseVariableType(colon, variable) == 0);
+		else if(line[0] == 'L' && !hasAddress)
+			hasAddress = ((colon = strrchr(&line[2], ':')) != NULL && sscanf(colon + 1, "%x", &variable->address) == 1);
+	}
+
+	fclose(file);
+
+	if(!(hasType && hasAddress))
+	{
+		ERROR("no XDATA variable \"%s\" in \"%s\"\n", name, filename);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Billy Millare
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * 18oct2026
+ */
+
+/**
+ * code symbols from SDCC output files
+ *
+ * .map	- linker map; "C:" (code) symbols of the global symbol lists
+ * .rst	- relocated listing; labels in areas with the CODE attribute
+ * .cdb	- debugger file; functions, with start ("L:G$" / "L:F") and end
+ *        ("L:XG$" / "L:XF") linker records
+ *
+ * and XDATA variables from the symbol ("S:") and linker ("L:") records of
+ *   .cdb files
+ */
+
+#ifndef SDCC_H_
+#define SDCC_H_
+
+/**
+ * NOTE:
+ *   to print error and warning messages, define SDCC_VERBOSE
+ */
+
+/**
+ * code symbol
+ */
+typedef struct {
+	unsigned int address;
+	unsigned int endAddress;	/* address past the last byte, 0 if unknown */
+	char *name;
+} SdccSymbol;
+
+/**
+ * code symbols sorted by address
+ */
+typedef struct {
+	unsigned int numberOfSymbols;
+	unsigned int capacity;
+	SdccSymbol *symbols;
+} SdccSymbols;
+
+/**
+ * initialize the symbols structure
+ *
+ * symbols - SdccSymbols to initialize
+ */
+void sdcc_initializeSymbols(SdccSymbols *symbols);
+
+/**
+ * clean-up the symbols structure
+ *
+ * symbols - SdccSymbols to clean-up
+ */
+void sdcc_destroySymbols(SdccSymbols *symbols);
+
+/**
+ * load code symbols from a .map, .rst, or .cdb file, going by its extension
+ *
+ * symbols - SdccSymbols to load symbols into
+ * filename - name of the file
+ *
+ * 0 if successful, non-zero otherwise
+ *
+ * note: several files can be loaded into the same symbols structure
+ */
+int sdcc_loadSymbols(SdccSymbols *symbols, const char *filename);
+
+/**
+ * find the code symbol containing an address
+ *
+ * symbols - SdccSymbols to search
+ * address - code address
+ *
+ * the symbol at or closest below address, NULL if none or if address is
+ *   past the end of that symbol
+ */
+const SdccSymbol * sdcc_findSymbol(const SdccSymbols *symbols, unsigned int address);
+
+/**
+ * find a code symbol by name
+ *
+ * symbols - SdccSymbols to search
+ * name - symbol name
+ *
+ * the first symbol with that name, NULL if none
+ */
+const SdccSymbol * sdcc_findSymbolByName(const SdccSymbols *symbols, const char *name);
+
+/**
+ * variable types
+ */
+enum {
+	SDCC_TYPE_UNKNOWN,	/* anything else, e.g. arrays, pointers, structures */
+	SDCC_TYPE_U8,
+	SDCC_TYPE_S8,
+	SDCC_TYPE_U16,
+	SDCC_TYPE_S16,
+	SDCC_TYPE_U32,
+	SDCC_TYPE_S32,
+	SDCC_TYPE_F32
+};
+
+/**
+ * XDATA variable
+ */
+typedef struct {
+	unsigned int address;
+	unsigned int size;
+	int type;			/* SDCC_TYPE_* */
+} SdccVariable;
+
+/**
+ * find a global or file-scope XDATA variable in a .cdb file
+ *
+ * filename - name of the .cdb file
+ * name - variable name
+ * variable - receives the variable's address, size, and type
+ *
+ * returns 0 if found, non-zero otherwise
+ */
+int sdcc_findVariable(const char *filename, const char *name, SdccVariable *variable);
+
+#endif /* SDCC_H_ */